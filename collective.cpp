@@ -66,6 +66,7 @@
 #include "dancing.h"
 #include "assembled_minion.h"
 #include "creature_experience_info.h"
+#include "sim_benchmark.h"
 
 template <class Archive>
 void Collective::serialize(Archive& ar, const unsigned int version) {
@@ -227,6 +228,7 @@ void Collective::removeCreature(Creature* c) {
   for (MinionTrait t : ENUM_ALL(MinionTrait))
     byTrait[t].removeElementMaybePreserveOrder(c);
   updateCreatureStatus(c);
+  control->onMemberRemoved(c);
 }
 
 void Collective::banishCreature(Creature* c) {
@@ -612,6 +614,7 @@ void Collective::updateMinionPromotions() {
 
 void Collective::tick() {
   PROFILE_BLOCK("Collective::tick");
+  BENCHMARK_PHASE(COLLECTIVE_TICK);
   updateBorderTiles();
   considerRebellion();
   updateGuardTasks();
@@ -620,6 +623,8 @@ void Collective::tick() {
   control->tick();
   zones->tick();
   taskMap->tick();
+  if (taskMap->clearChanged())
+    control->onTasksChanged();
   constructions->clearUnsupportedFurniturePlans();
   dancing->setArea(zones->getPositions(ZoneId::LEISURE), getModel()->getLocalTime());
   if (config->getWarnings() && Random.roll(5))
@@ -1016,6 +1021,7 @@ void Collective::takeResource(const CostInfo& cost) {
   if (num == 0)
     return;
   CHECK(num > 0);
+  control->onResourcesChanged();
   if (credit[cost.id]) {
     if (credit[cost.id] >= num) {
       credit[cost.id] -= num;
@@ -1042,6 +1048,7 @@ void Collective::returnResource(const CostInfo& amount) {
   if (amount.value == 0)
     return;
   CHECK(amount.value > 0);
+  control->onResourcesChanged();
   auto& info = getResourceInfo(amount.id);
   if (info.itemId) {
     auto items = info.itemId->get(amount.value, getGame()->getContentFactory());
@@ -18,6 +18,9 @@ class CollectiveControl : public OwnedObject<CollectiveControl> {
   virtual void onMemberKilledOrStunned(Creature* victim, const Creature* killer);
   virtual void onOtherKilled(const Creature* victim, const Creature* killer);
   virtual void onMemberAdded(Creature*) {}
+  virtual void onMemberRemoved(Creature*) {}
+  virtual void onResourcesChanged() {}
+  virtual void onTasksChanged() {}
   virtual void onConquered(Creature* victim, Creature* killer) {}
   virtual void addMessage(const PlayerMessage&) {}
   virtual void addWindowMessage(ViewIdList, const string&) {}
@@ -24,6 +24,8 @@
 #include "tile_gas_info.h"
 #include "promotion_info.h"
 #include "buff_info.h"
+#include "sectioned_file.h"
+#include "version.h"
 
 template <class Archive>
 void ContentFactory::serialize(Archive& ar, const unsigned int version) {
@@ -492,6 +494,58 @@ optional<string> ContentFactory::readData(const GameConfig* config, const vector
 }
 
 
+// Hash of everything that readData reads. Layouts are read from images in map_layouts subdirectories.
+static size_t getInputHash(const GameConfig* config, const vector<string>& modNames) {
+  size_t ret = combineHash(string(BUILD_VERSION), string(BUILD_DATE), modNames);
+  auto addFiles = [&ret] (const DirectoryPath& dir) {
+    auto files = dir.getFiles();
+    std::sort(files.begin(), files.end(),
+        [](const FilePath& f1, const FilePath& f2) { return strcmp(f1.getFileName(), f2.getFileName()) < 0; });
+    for (auto& file : files)
+      ret = combineHash(ret, string(file.getFileName()), file.readContents());
+  };
+  for (auto& dir : config->dirs) {
+    addFiles(dir);
+    auto layoutsDir = dir.subdirectory("map_layouts");
+    auto subdirs = layoutsDir.getSubDirs();
+    std::sort(subdirs.begin(), subdirs.end());
+    for (auto& subdir : subdirs)
+      addFiles(layoutsDir.subdirectory(subdir));
+  }
+  return ret;
+}
+
+optional<string> ContentFactory::readDataCached(const GameConfig* config, const vector<string>& modNames,
+    const FilePath& cachePath) {
+  auto inputHash = getInputHash(config, modNames);
+  if (cachePath.exists())
+    try {
+      SectionedInput input(cachePath);
+      size_t cachedHash = 0;
+      input.readSection("key", cachedHash);
+      if (cachedHash == inputHash) {
+        input.readSection("content", *this);
+        // The names were permuted when the cache was written, so every game would get them in the same order.
+        creatures.getNameGenerator()->shuffle();
+        INFO << "Loaded content from cache " << cachePath.getPath();
+        return none;
+      }
+    } catch (std::exception& e) {
+      INFO << "Error reading content cache " << cachePath.getPath() << ": " << e.what();
+      *this = ContentFactory();
+    }
+  if (auto error = readData(config, modNames))
+    return error;
+  try {
+    SectionedOutput output(cachePath);
+    output.addSection("key", inputHash);
+    output.addSection("content", *this);
+  } catch (std::exception& e) {
+    INFO << "Error writing content cache " << cachePath.getPath() << ": " << e.what();
+  }
+  return none;
+}
+
 
 void ContentFactory::merge(ContentFactory f) {
   creatures.merge(std::move(f.creatures));
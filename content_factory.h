@@ -31,6 +31,7 @@
 #include "achievement_info.h"
 
 class KeyVerifier;
+class FilePath;
 class BuildInfo;
 class ExternalEnemy;
 class ResourceDistribution;
@@ -47,6 +48,9 @@ struct BodyMaterial;
 class ContentFactory {
   public:
   optional<string> readData(const GameConfig*, const vector<string>& modNames);
+  // Same as readData, but loads the content from the cache file if none of the input files, mods or the build
+  // changed since it was written. Otherwise parses the files and writes the cache.
+  optional<string> readDataCached(const GameConfig*, const vector<string>& modNames, const FilePath& cachePath);
   vector<WorldMapInfo> SERIAL(worldMaps);
   FurnitureFactory SERIAL(furniture);
   map<string, vector<ZLevelInfo>> SERIAL(zLevels);
@@ -35,22 +35,54 @@ void setInitializedStatics() {
 }
 
 
-template<typename T>
-vector<string>& ContentId<T>::getAllIds() {
-  static vector<string> ret;
+// Ids are created from literals on several threads at once, for example by level generation and off-screen model
+// updates. The names are kept in blocks that never move, and a name is written before its id is handed out, so
+// reading it takes no lock.
+struct ContentIdNames {
+  static constexpr int blockSize = 256;
+  static constexpr int maxIds = 1 << 15;
+  std::mutex mutex;
+  unordered_map<string, int> ids;
+  std::array<unique_ptr<string[]>, maxIds / blockSize> blocks;
+  int numIds = 0;
+};
+
+template <typename T>
+static ContentIdNames& getContentIdNames() {
+  static ContentIdNames ret;
   assert(staticsInitialized && !strcmp(staticsInitialized, "initialized"));
   return ret;
 }
 
+template<typename T>
+const char* ContentId<T>::getName(InternalId id) {
+  auto& names = getContentIdNames<T>();
+  return names.blocks[id / names.blockSize][id % names.blockSize].data();
+}
+
 template <typename T>
 int ContentId<T>::getId(const char* text) {
-  static unordered_map<string, int> ids;
-  static int generatedId = 0;
-  if (auto ret = getReferenceMaybe(ids, text))
+  // Every thread remembers the ids it has seen, so only new ids take the lock.
+  static thread_local unordered_map<string, int> seenIds;
+  if (auto ret = getReferenceMaybe(seenIds, text))
     return *ret;
-  ids[text] = generatedId;
-  getAllIds().push_back(text);
-  return generatedId++;
+  auto& names = getContentIdNames<T>();
+  std::lock_guard<std::mutex> lock(names.mutex);
+  int id;
+  if (auto ret = getReferenceMaybe(names.ids, text))
+    id = *ret;
+  else {
+    id = names.numIds;
+    CHECK(id < names.maxIds) << "Too many content ids";
+    auto& block = names.blocks[id / names.blockSize];
+    if (!block)
+      block.reset(new string[names.blockSize]);
+    block[id % names.blockSize] = text;
+    names.ids[text] = id;
+    ++names.numIds;
+  }
+  seenIds[text] = id;
+  return id;
 }
 
 template <typename T>
@@ -91,7 +123,7 @@ int ContentId<T>::getHash() const {
 
 template <typename T>
 const char* ContentId<T>::data() const {
-  return getAllIds()[id].data();
+  return getName(id);
 }
 
 template <typename T>
@@ -156,7 +188,7 @@ int PrimaryId<T>::getHash() const {
 
 template<typename T>
 const char* PrimaryId<T>::data() const {
-  return ContentId<T>::getAllIds()[id].data();
+  return ContentId<T>::getName(id);
 }
 
 template<typename T>
@@ -28,7 +28,7 @@ class ContentId {
   private:
   friend PrimaryId<T>;
   InternalId id;
-  static vector<string>& getAllIds();
+  static const char* getName(InternalId);
   static int getId(const char* text);
 };
 
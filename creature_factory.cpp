@@ -301,7 +301,9 @@ void CreatureFactory::merge(CreatureFactory f) {
 }
 
 void CreatureFactory::setContentFactory(const ContentFactory* f) const {
-  contentFactory = f;
+  // Called every time the factory is accessed, also from worker threads. Once set, the pointer is only read.
+  if (contentFactory != f)
+    contentFactory = f;
 }
 
 CreatureFactory::CreatureFactory(CreatureFactory&&) noexcept = default;
@@ -76,9 +76,11 @@ class DebugLog {
   public:
   void addOutput(DebugOutput);
 
+  // Holds the log's lock until the end of the line, so lines logged from worker threads don't interleave.
   class Logger {
     public:
-    Logger(std::vector<DebugOutput>& s) : outputs(s) {}
+    Logger(std::vector<DebugOutput>& s, recursive_mutex& m) : outputs(s), lock(m) {}
+    Logger(Logger&&) = default;
 
     template <typename T>
     Logger& operator << (const T& t) {
@@ -87,18 +89,21 @@ class DebugLog {
       return *this;
     }
     ~Logger() {
-      for (int i = outputs.size() - 1; i >= 0; --i)
-        outputs[i].onLineEnd();
+      if (lock.owns_lock())
+        for (int i = outputs.size() - 1; i >= 0; --i)
+          outputs[i].onLineEnd();
     }
 
     private:
     std::vector<DebugOutput>& outputs;
+    RecursiveLock lock;
   };
 
   Logger get();
 
   private:
   std::vector<DebugOutput> outputs;
+  recursive_mutex mutex;
 };
 
 extern DebugLog InfoLog;
@@ -27,6 +27,10 @@ EnemyFactory::EnemyFactory(RandomGen& r, NameGenerator* n, map<EnemyId, EnemyInf
     externalEnemies(std::move(externalEnemies)) {
 }
 
+EnemyFactory EnemyFactory::withRandom(RandomGen& r) const {
+  return EnemyFactory(r, nameGenerator, enemies, buildingInfo, externalEnemies);
+}
+
 PCollective EnemyInfo::buildCollective(ContentFactory* contentFactory) const {
   if (settlement.locationName)
     settlement.collective->setLocationName(*settlement.locationName);
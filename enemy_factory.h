@@ -18,6 +18,8 @@ class EnemyFactory {
       vector<ExternalEnemy>);
   EnemyFactory(const EnemyFactory&) = delete;
   EnemyFactory(EnemyFactory&&) = default;
+  // Copy that draws from a different generator, so that sites can be generated on several threads.
+  EnemyFactory withRandom(RandomGen&) const;
   EnemyInfo get(EnemyId) const;
   vector<ExternalEnemy> getExternalEnemies() const;
   vector<ExternalEnemy> getHalloweenKids();
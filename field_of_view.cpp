@@ -25,13 +25,13 @@ template <class Archive>
 void FieldOfView::serialize(Archive& ar, const unsigned int) {
   ar(level, vision, blocking);
   if (Archive::is_loading::value)
-    visibility = Table<unique_ptr<Visibility>>(level->getBounds());
+    visibilityIndex = Table<int>(level->getBounds(), -1);
 }
 
 #ifdef MEM_USAGE_TEST
 template <>
 void FieldOfView::serialize(MemUsageArchive& ar1, const unsigned int) {
-  ar1(level, vision, blocking, visibility);
+  ar1(level, vision, blocking);
 }
 #endif
 
@@ -40,17 +40,8 @@ template void FieldOfView::serialize(OutputArchive&, unsigned);
 
 SERIALIZATION_CONSTRUCTOR_IMPL(FieldOfView)
 
-template <typename Archive>
-void FieldOfView::Visibility::serialize(Archive& ar, const unsigned int) {
-  ar(visibleTiles);
-}
-
-SERIALIZABLE(FieldOfView::Visibility)
-
-SERIALIZATION_CONSTRUCTOR_IMPL2(FieldOfView::Visibility, Visibility)
-
 FieldOfView::FieldOfView(Level* l, VisionId v, const ContentFactory* factory)
-    : level(l), visibility(l->getBounds()), vision(v), blocking(l->getBounds().minusMargin(-1), true) {
+    : level(l), visibilityIndex(l->getBounds(), -1), vision(v), blocking(l->getBounds().minusMargin(-1), true) {
   for (auto v : blocking.getBounds())
     blocking[v] = !Position(v, level).canSeeThru(vision, factory);
 }
@@ -59,28 +50,131 @@ bool FieldOfView::canSee(Vec2 from, Vec2 to) {
   PROFILE;;
   if ((from - to).lengthD() > sightRange)
     return false;
-  if (!visibility[from])
-    visibility[from].reset(new Visibility(level->getBounds(), blocking, from.x, from.y));
-  return visibility[from]->checkVisible(to.x - from.x, to.y - from.y);
+  return getVisibility(from).checkVisible(to.x - from.x, to.y - from.y);
+}
+
+static long long memoryBudgetPerLevel = 24 * 1024 * 1024;
+// Evicting entries that were used very recently could invalidate references held by callers.
+const int minCachedVisibilities = 64;
+
+void FieldOfView::setMemoryBudget(long long bytes) {
+  memoryBudgetPerLevel = bytes;
+}
+
+long long FieldOfView::Visibility::getMemoryUsage() const {
+  return sizeof(Visibility) + (visibleTiles ? visibleTiles->capacity() * sizeof(SVec2) : 0);
+}
+
+FieldOfViewCacheStats& FieldOfViewCacheStats::operator += (const FieldOfViewCacheStats& o) {
+  hits += o.hits;
+  misses += o.misses;
+  evictions += o.evictions;
+  invalidations += o.invalidations;
+  bytes += o.bytes;
+  entries += o.entries;
+  return *this;
+}
+
+const FieldOfViewCacheStats& FieldOfView::getCacheStats() const {
+  return cacheStats;
+}
+
+void FieldOfView::unlink(int index) {
+  auto& elem = *visibilityPool[index];
+  if (elem.prev >= 0)
+    visibilityPool[elem.prev]->next = elem.next;
+  else
+    lruHead = elem.next;
+  if (elem.next >= 0)
+    visibilityPool[elem.next]->prev = elem.prev;
+  else
+    lruTail = elem.prev;
+  elem.prev = elem.next = -1;
+}
+
+void FieldOfView::pushFront(int index) {
+  auto& elem = *visibilityPool[index];
+  elem.prev = -1;
+  elem.next = lruHead;
+  if (lruHead >= 0)
+    visibilityPool[lruHead]->prev = index;
+  lruHead = index;
+  if (lruTail < 0)
+    lruTail = index;
+}
+
+int FieldOfView::allocateVisibility() {
+  if (!freeVisibilities.empty()) {
+    int index = freeVisibilities.back();
+    freeVisibilities.pop_back();
+    return index;
+  }
+  long long budget = memoryBudgetPerLevel / EnumInfo<VisionId>::size;
+  if (cacheStats.bytes >= budget && cacheStats.entries >= minCachedVisibilities) {
+    int index = lruTail;
+    ++cacheStats.evictions;
+    freeVisibility(visibilityPool[index]->viewer);
+    freeVisibilities.pop_back();
+    return index;
+  }
+  visibilityPool.push_back(make_unique<Visibility>());
+  cacheStats.bytes += visibilityPool.back()->getMemoryUsage();
+  return visibilityPool.size() - 1;
+}
+
+const FieldOfView::Visibility& FieldOfView::getVisibility(Vec2 pos) {
+  int& index = visibilityIndex[pos];
+  if (index == -1) {
+    ++cacheStats.misses;
+    int newIndex = allocateVisibility();
+    auto& elem = *visibilityPool[newIndex];
+    cacheStats.bytes -= elem.getMemoryUsage();
+    calculate(elem, pos);
+    cacheStats.bytes += elem.getMemoryUsage();
+    ++cacheStats.entries;
+    index = newIndex;
+    pushFront(index);
+  } else {
+    ++cacheStats.hits;
+    if (index != lruHead) {
+      unlink(index);
+      pushFront(index);
+    }
+  }
+  return *visibilityPool[index];
+}
+
+void FieldOfView::freeVisibility(Vec2 pos) {
+  int index = visibilityIndex[pos];
+  unlink(index);
+  freeVisibilities.push_back(index);
+  visibilityIndex[pos] = -1;
+  --cacheStats.entries;
 }
 
 void FieldOfView::squareChanged(Vec2 pos) {
   PROFILE;
-  blocking[pos] = !Position(pos, level).canSeeThru(vision);
-  vector<Vec2> updateList;
-  if (!visibility[pos])
-    visibility[pos].reset(new Visibility(level->getBounds(), blocking, pos.x, pos.y));
-  for (Vec2 v : Rectangle::centered(pos, sightRange))
-    if (v.inRectangle(visibility.getBounds()) && visibility[v] && visibility[v]->checkVisible(pos.x - v.x, pos.y - v.y)) {
-      visibility[v].reset();
+  bool isBlocking = !Position(pos, level).canSeeThru(vision);
+  // Visibility only depends on the blocking squares, so other changes don't affect any viewer.
+  if (blocking[pos] == isBlocking)
+    return;
+  blocking[pos] = isBlocking;
+  // A viewer's result changes only if its rays reach the square, which means that it can see it.
+  for (Vec2 v : Rectangle::centered(pos, sightRange).intersection(visibilityIndex.getBounds())) {
+    int index = visibilityIndex[v];
+    if (index >= 0 && visibilityPool[index]->checkVisible(pos.x - v.x, pos.y - v.y)) {
+      freeVisibility(v);
+      ++cacheStats.invalidations;
     }
+  }
 }
 
-void FieldOfView::Visibility::setVisible(Rectangle bounds, int x, int y) {
-  if (Vec2(px + x, py + y).inRectangle(bounds) &&
-      !visible[x + sightRange][y + sightRange] && x * x + y * y <= sightRange * sightRange) {
-    visible[x + sightRange][y + sightRange] = 1;
-    visibleTiles.push_back(SVec2{short(px + x), short(py + y)});
+void FieldOfView::Visibility::setVisible(Rectangle bounds, Vec2 viewer, int x, int y) {
+  auto& row = rows[y + sightRange];
+  const uint64_t bit = uint64_t(1) << (x + sightRange);
+  if (!(row & bit) && x * x + y * y <= sightRange * sightRange && (viewer + Vec2(x, y)).inRectangle(bounds)) {
+    row |= bit;
+    visibleTiles->push_back(SVec2{short(viewer.x + x), short(viewer.y + y)});
   }
 }
 
@@ -123,42 +217,37 @@ static void calculate(int left, int right, int up, int h, int x1, int y1, int x2
   calculate(left, right, up, h + 2, leftx, lefty, rightx, righty, isBlocking, setVisible);
 }
 
-FieldOfView::Visibility::Visibility(Rectangle bounds, const Table<bool>& blocking, int x, int y) : px(x), py(y) {
+void FieldOfView::calculate(Visibility& visibility, Vec2 pos) {
   PROFILE;
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
+  visibility.rows.fill(0);
+  if (!visibility.visibleTiles || visibility.visibleTiles.use_count() > 1)
+    visibility.visibleTiles = make_shared<vector<SVec2>>();
+  else
+    visibility.visibleTiles->clear();
+  visibility.viewer = pos;
+  auto bounds = level->getBounds();
+  int x = pos.x;
+  int y = pos.y;
+  ::calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
       [&](int px, int py) { return blocking[Vec2(x + px, y + py)]; },
-      [&](int px, int py) { setVisible(bounds, px, py); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
+      [&](int px, int py) { visibility.setVisible(bounds, pos, px, py); });
+  ::calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
       [&](int px, int py) { return blocking[Vec2(x + py, y - px)]; },
-      [&](int px, int py) { setVisible(bounds, py, -px); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
+      [&](int px, int py) { visibility.setVisible(bounds, pos, py, -px); });
+  ::calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
       [&](int px, int py) { return blocking[Vec2(x - px, y - py)]; },
-      [&](int px, int py) { setVisible(bounds, -px, -py); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
+      [&](int px, int py) { visibility.setVisible(bounds, pos, -px, -py); });
+  ::calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
       [&](int px, int py) { return blocking[Vec2(x - py, y + px)]; },
-      [&](int px, int py) { setVisible(bounds, -py, px); });
-  setVisible(bounds, 0, 0);
-  visibleTiles.shrink_to_fit();
-/*  ++numSamples;
-  totalIter += visibleTiles.size();
-  if (numSamples%100 == 0)
-    INFO << numSamples << " iterations " << totalIter / numSamples << " avg";*/
-}
-
-const vector<SVec2>& FieldOfView::Visibility::getVisibleTiles() const {
-  return visibleTiles;
+      [&](int px, int py) { visibility.setVisible(bounds, pos, -py, px); });
+  visibility.setVisible(bounds, pos, 0, 0);
 }
 
-const vector<SVec2>& FieldOfView::getVisibleTiles(Vec2 from) {
-  if (!visibility[from]) {
-    visibility[from].reset(new Visibility(level->getBounds(), blocking, from.x, from.y));
-  }
-  return visibility[from]->getVisibleTiles();
+shared_ptr<const vector<SVec2>> FieldOfView::getVisibleTiles(Vec2 from) {
+  return getVisibility(from).visibleTiles;
 }
 
 bool FieldOfView::Visibility::checkVisible(int x, int y) const {
   return x >= -sightRange && y >= -sightRange && x <= sightRange && y <= sightRange &&
-    visible[sightRange + x][sightRange + y] == 1;
+    (rows[sightRange + y] >> (sightRange + x)) & 1;
 }
-
-
@@ -21,42 +21,66 @@ class Square;
 class SquareArray;
 class ContentFactory;
 
+struct FieldOfViewCacheStats {
+  long long hits = 0;
+  long long misses = 0;
+  long long evictions = 0;
+  long long invalidations = 0;
+  long long bytes = 0;
+  int entries = 0;
+  FieldOfViewCacheStats& operator += (const FieldOfViewCacheStats&);
+};
+
 class FieldOfView {
   public:
   FieldOfView(Level*, VisionId, const ContentFactory*);
   bool canSee(Vec2 from, Vec2 to);
-  const vector<SVec2>& getVisibleTiles(Vec2 from);
+  // The returned list stays valid and unchanged after its cache entry is evicted or recalculated.
+  shared_ptr<const vector<SVec2>> getVisibleTiles(Vec2 from);
   void squareChanged(Vec2 pos);
 
+  const FieldOfViewCacheStats& getCacheStats() const;
+
+  // Memory budget of the visibility cache of a single level, shared between all VisionIds.
+  static void setMemoryBudget(long long bytesPerLevel);
+
   SERIALIZATION_DECL(FieldOfView)
 
   static constexpr int sightRange = 30;
 
   private:
-
-
-  class Visibility {
-    public:
-
-    bool checkVisible(int x,int y) const;
-    const vector<SVec2>& getVisibleTiles() const;
-
-    Visibility(Rectangle bounds, const Table<bool>& blocking, int x, int y);
-
-    SERIALIZATION_DECL(Visibility)
-
-    private:
-    array<bitset<sightRange * 2 + 1>, sightRange * 2 + 1> visible;
-    vector<SVec2> SERIAL(visibleTiles);
-    void setVisible(Rectangle bounds, int, int);
-
-    int px;
-    int py;
+  // Visible squares around a single viewer, as one bit mask per row and as a list.
+  struct Visibility {
+    bool checkVisible(int x, int y) const;
+    void setVisible(Rectangle bounds, Vec2 viewer, int x, int y);
+    long long getMemoryUsage() const;
+    array<uint64_t, sightRange * 2 + 1> rows;
+    // Replaced instead of reused while a list returned by getVisibleTiles() still holds it.
+    shared_ptr<vector<SVec2>> visibleTiles;
+    Vec2 viewer;
+    // Neighbors on the LRU list, or -1 for free entries.
+    int prev = -1;
+    int next = -1;
   };
+  static_assert(sightRange * 2 + 1 <= 64, "Rows of Visibility don't fit in 64 bits");
+
+  const Visibility& getVisibility(Vec2);
+  int allocateVisibility();
+  void calculate(Visibility&, Vec2);
+  void freeVisibility(Vec2);
+  void unlink(int index);
+  void pushFront(int index);
 
   Level* SERIAL(level) = nullptr;
-  Table<unique_ptr<Visibility>> visibility;
+  // Index into visibilityPool or -1. Freed entries are kept and reused together with their allocated tile lists.
+  // Entries are allocated separately, so that references to them stay valid when the pool grows.
+  // Once the pool reaches the memory budget, the least recently used entries are reused instead.
+  Table<int> visibilityIndex;
+  vector<unique_ptr<Visibility>> visibilityPool;
+  vector<int> freeVisibilities;
+  int lruHead = -1;
+  int lruTail = -1;
+  FieldOfViewCacheStats cacheStats;
   VisionId SERIAL(vision);
   Table<bool> SERIAL(blocking);
 };
-
@@ -4,6 +4,9 @@
 #include "util.h"
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifdef WINDOWS
+#include <windows.h>
+#endif
 
 FilePath FilePath::fromFullPath(const std::string& path) {
   return FilePath(split(path, {'/'}).back(), path);
@@ -93,3 +96,11 @@ void FilePath::copyTo(FilePath to) const {
   ofstream out(to.fullPath, std::ios::binary);
   out << in.rdbuf();
 }
+
+bool FilePath::renameTo(FilePath to) const {
+#ifdef WINDOWS
+  return MoveFileExA(fullPath.c_str(), to.fullPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+  return rename(fullPath.c_str(), to.fullPath.c_str()) == 0;
+#endif
+}
@@ -21,6 +21,8 @@ class FilePath {
   FilePath absolute() const;
 
   void copyTo(FilePath) const;
+  // Replaces the destination with this file in one step, so it's never left half written. Returns false on failure.
+  bool renameTo(FilePath) const;
 
   private:
   friend class DirectoryPath;
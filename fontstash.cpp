@@ -705,6 +705,40 @@ void sth_draw_text(struct sth_stash* stash,
 	if (dx) *dx = x;
 }
 
+void sth_get_text_quads(struct sth_stash* stash,
+				   int idx, float size,
+				   float x, float y,
+				   const char* s, std::vector<sth_text_quad>& quads)
+{
+	unsigned int codepoint;
+  struct sth_glyph* glyph = nullptr;
+	unsigned int state = 0;
+	struct sth_quad q;
+	short isize = (short)(size*10.0f);
+  struct sth_font* fnt = nullptr;
+
+  if (stash == nullptr)
+    return;
+	fnt = stash->fonts;
+  while(fnt != nullptr && fnt->idx != idx) fnt = fnt->next;
+  if (fnt == nullptr)
+    return;
+	if (fnt->type != BMFONT && !fnt->data)
+        return;
+
+	for (; *s; ++s)
+	{
+		if (decutf8(&state, &codepoint, *(unsigned char*)s))
+            continue;
+		glyph = get_glyph(stash, fnt, codepoint, isize);
+		if (!glyph)
+            continue;
+		if (!get_quad(stash, fnt, glyph, isize, &x, &y, &q))
+            continue;
+		quads.push_back(sth_text_quad{glyph->texture->id, q.x0, q.y0, q.s0, q.t0, q.x1, q.y1, q.s1, q.t1});
+	}
+}
+
 void sth_dim_text(struct sth_stash* stash,
 				  int idx, float size,
 				  const char* s,
@@ -29,6 +29,7 @@
 // not enough memory
 #define STH_ENOMEM -4
 
+#include <vector>
 #include "opengl.h"
 
 struct sth_stash* sth_create(int cachew, int cacheh);
@@ -51,6 +52,19 @@ void sth_draw_text(struct sth_stash* stash,
 				   int idx, float size,
 				   float x, float y, const char* string, float* dx);
 
+struct sth_text_quad
+{
+	SDL::GLuint texture;
+	float x0,y0,s0,t0;
+	float x1,y1,s1,t1;
+};
+
+// Computes the quads of the string without drawing anything. The glyphs stay in the cache textures until the stash is
+// deleted, so the quads can be kept and drawn later.
+void sth_get_text_quads(struct sth_stash* stash,
+				   int idx, float size,
+				   float x, float y, const char* string, std::vector<sth_text_quad>& quads);
+
 void sth_dim_text(struct sth_stash* stash, int idx, float size, const char* string,
 				  float* minx, float* miny, float* maxx, float* maxy);
 
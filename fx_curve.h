@@ -20,6 +20,7 @@ template <class T> struct Curve {
 
   // Position is always within range: <0, 1>
   T sample(float position) const;
+  bool isConstant() const { return num_keys <= 1; }
 
   void print(int num_steps = 20) const;
 
@@ -86,6 +86,8 @@ using PrepareEmissionFunc = float (*)(AnimationContext&, EmissionState&);
 using EmitParticleFunc = function<void(AnimationContext&, EmissionState&, Particle&)>;
 
 void defaultAnimateParticle(AnimationContext&, Particle&);
+// Animates with defaultAnimateParticle and removes the dead particles in the same pass.
+void defaultAnimateParticles(AnimationContext&, vector<Particle>&);
 float defaultPrepareEmission(AnimationContext&, EmissionState&);
 void defaultEmitParticle(AnimationContext&, EmissionState&, Particle&);
 bool defaultDrawParticle(DrawContext&, const Particle&, DrawParticle&);
@@ -69,26 +69,26 @@ void FXManager::simulate(ParticleSystem &ps, float timeDelta) {
   PROFILE;
   auto &psdef = (*this)[ps.defId];
 
-  // Animating live particles
+  // Animating live particles and removing dead ones
   for (int ssid = 0; ssid < (int)psdef.subSystems.size(); ssid++)
     if (!ps[ssid].particles.empty()) {
       auto &ss = ps[ssid];
       auto &ssdef = psdef[ssid];
       AnimationContext ctx(ssctx(ps, ssid), globalSimTime, ps.animTime, timeDelta);
 
-      for (auto &pinst : ss.particles)
-        ssdef.animateFunc(ctx, pinst);
-      ss.randomSeed = ctx.randomSeed();
-    }
-  // Removing dead particles
-  for (auto &ssinst : ps.subSystems)
-    for (int n = 0; n < (int)ssinst.particles.size(); n++) {
-      auto &pinst = ssinst.particles[n];
-      if (pinst.life > pinst.maxLife) {
-        pinst = ssinst.particles.back();
-        ssinst.particles.pop_back();
-        n--;
+      if (ssdef.animateFunc == &defaultAnimateParticle)
+        defaultAnimateParticles(ctx, ss.particles);
+      else {
+        // Particles are animated in place, because some functions depend on their index.
+        int numAlive = 0;
+        for (auto &pinst : ss.particles) {
+          ssdef.animateFunc(ctx, pinst);
+          if (pinst.life <= pinst.maxLife)
+            ss.particles[numAlive++] = pinst;
+        }
+        ss.particles.resize(numAlive);
       }
+      ss.randomSeed = ctx.randomSeed();
     }
 
   // Emitting new particles
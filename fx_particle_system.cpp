@@ -98,6 +98,37 @@ void defaultAnimateParticle(AnimationContext &ctx, Particle &pinst) {
   pinst.life += ctx.timeDelta;
 }
 
+void defaultAnimateParticles(AnimationContext &ctx, vector<Particle> &particles) {
+  const auto &slowdownCurve = ctx.pdef.slowdown;
+  const float timeDelta = ctx.timeDelta;
+  // Most particles use a constant slowdown, so pow() can be computed once for all of them.
+  const bool constantSlowdown = slowdownCurve.isConstant();
+  float constantFactor = 1.0f;
+  if (constantSlowdown) {
+    float slowdown = 1.0f / (1.0f + slowdownCurve.sample(0.0f));
+    if (slowdown < 1.0f)
+      constantFactor = pow(slowdown, timeDelta);
+  }
+  int numAlive = 0;
+  for (auto &pinst : particles) {
+    float factor = constantFactor;
+    if (!constantSlowdown) {
+      float slowdown = 1.0f / (1.0f + slowdownCurve.sample(pinst.particleTime()));
+      factor = slowdown < 1.0f ? pow(slowdown, timeDelta) : 1.0f;
+    }
+    pinst.pos += pinst.movement * timeDelta;
+    pinst.rot += pinst.rotSpeed * timeDelta;
+    if (factor < 1.0f) {
+      pinst.movement *= factor;
+      pinst.rotSpeed *= factor;
+    }
+    pinst.life += timeDelta;
+    if (pinst.life <= pinst.maxLife)
+      particles[numAlive++] = pinst;
+  }
+  particles.resize(numAlive);
+}
+
 float defaultPrepareEmission(AnimationContext &ctx, EmissionState &em) {
   auto &pdef = ctx.pdef;
   auto &edef = ctx.edef;
@@ -15,6 +15,7 @@
 #include "options.h"
 #include "territory.h"
 #include "level.h"
+#include "field_of_view.h"
 #include "highscores.h"
 #include "player.h"
 #include "item_factory.h"
@@ -457,7 +458,44 @@ void Game::updateSunlightMovement() {
       }
 }
 
+namespace {
+// Interactions of an off-screen site with the rest of the game, which are applied at the end of its update.
+struct OffscreenChanges {
+  Model* model;
+  vector<GameEvent> events;
+  struct Transfer {
+    Creature* creature;
+    Model* to;
+    vector<Position> destinations;
+  };
+  vector<Transfer> transfers;
+  // Changes to the shared tribes, achievements and analytics, applied on the main thread.
+  vector<function<void()>> tribeChanges;
+  vector<AchievementId> achievements;
+  vector<pair<string, string>> analytics;
+  // Names for creatures created by the update, drawn from the site's own share of the names.
+  NameGenerator* names;
+  // Thrown by the update, rethrown on the main thread.
+  std::exception_ptr exception;
+};
+}
+
+// Set on worker threads while they simulate an off-screen site.
+static thread_local OffscreenChanges* offscreenChanges = nullptr;
+
 void Game::tick(GlobalTime time) {
+#ifndef BUILD_WITH_EASY_PROFILER
+  if (Profiler::isEnabled()) {
+    FieldOfViewCacheStats stats;
+    for (auto model : getAllModels())
+      for (auto level : model->getLevels())
+        stats += level->getVisibilityCacheStats();
+    Profiler::addTurnNote("FOV cache: " + toString(stats.hits) + " hits, " + toString(stats.misses) + " misses, " +
+        toString(stats.evictions) + " evictions, " + toString(stats.invalidations) + " invalidations, " +
+        toString(stats.entries) + " entries, " + toString(stats.bytes / 1024) + " KB");
+  }
+  Profiler::endTurn(time.getVisibleInt());
+#endif
   PROFILE_BLOCK("Game::tick");
   if (!turnEvents.empty() && time.getVisibleInt() > *turnEvents.begin()) {
     auto turn = *turnEvents.begin();
@@ -479,9 +517,80 @@ void Game::tick(GlobalTime time) {
     if (isVillainActive(col))
       col->update(col->getModel() == getCurrentModel());
   }
+  updateOffscreenModels(time);
   considerAllianceAttack();
 }
 
+static unique_ptr<ThreadPool> offscreenThreadPool;
+
+void Game::setOffscreenSimulationThreads(int num) {
+  offscreenThreadPool.reset();
+  if (num > 0)
+    offscreenThreadPool = make_unique<ThreadPool>(num);
+}
+
+void Game::updateOffscreenModels(GlobalTime time) {
+  if (!offscreenThreadPool)
+    return;
+  PROFILE;
+  vector<Model*> offscreen;
+  for (auto model : getAllModels())
+    if (model != getCurrentModel() && (model == getMainModel().get() || campaign->isInInfluence(model->position))
+        && std::none_of(players.begin(), players.end(), [&](Creature* c) { return c->getPosition().getModel() == model; }))
+      offscreen.push_back(model);
+  if (offscreen.empty())
+    return;
+  // Every site is advanced by one turn with its own random generator and its own share of the names, independently
+  // of the thread that runs it. Sites don't touch each other until their changes are applied below in a fixed order.
+  auto nameGenerator = contentFactory->getCreatures().getNameGenerator();
+  auto nameParts = nameGenerator->split(offscreen.size());
+  vector<OffscreenChanges> changes;
+  for (int i : All(offscreen))
+    changes.push_back(OffscreenChanges{offscreen[i], {}, {}, {}, {}, {}, &nameParts[i], nullptr});
+  for (int i : All(offscreen)) {
+    auto model = offscreen[i];
+    auto& modelTime = localTime[model->getGroundLevel()->getUniqueId()];
+    modelTime += 1;
+    uint64_t seed = uint64_t(time.getVisibleInt()) * 1000003 + uint64_t(model->position.x) * 1009
+        + uint64_t(model->position.y);
+    offscreenThreadPool->addTask([model, targetTime = modelTime, seed = int(seed % 1000000007), nameGenerator,
+        change = &changes[i]] {
+      PROFILE_BLOCK("Offscreen model update");
+      RandomGen random;
+      random.init(seed);
+      ScopedRandomOverride randomOverride(random);
+      ScopedNameGeneratorOverride nameOverride(*nameGenerator, *change->names);
+      Tribe::deferChangesOnThisThread(&change->tribeChanges);
+      offscreenChanges = change;
+      try {
+        while (model->update(targetTime)) {}
+      } catch (...) {
+        change->exception = std::current_exception();
+      }
+      offscreenChanges = nullptr;
+      Tribe::deferChangesOnThisThread(nullptr);
+    });
+  }
+  offscreenThreadPool->wait();
+  for (auto& change : changes)
+    if (change.exception)
+      std::rethrow_exception(change.exception);
+  nameGenerator->join(nameParts);
+  for (auto& change : changes) {
+    for (auto& tribeChange : change.tribeChanges)
+      tribeChange();
+    for (auto& id : change.achievements)
+      achieve(id);
+    for (auto& elem : change.analytics)
+      addAnalytics(elem.first, elem.second);
+    for (auto& transfer : change.transfers)
+      if (!transfer.creature->isDead() && transfer.creature->getPosition().getModel() == change.model)
+        transferCreature(transfer.creature, transfer.to, transfer.destinations);
+    for (auto& event : change.events)
+      dispatchEvent(event, change.model);
+  }
+}
+
 void Game::setExitInfo(ExitInfo info) {
   exitInfo = std::move(info);
 }
@@ -530,6 +639,10 @@ Position Game::getTransferPos(Model* from, Model* to) const {
 }
 
 void Game::transferCreature(Creature* c, Model* to, const vector<Position>& destinations) {
+  if (offscreenChanges) {
+    offscreenChanges->transfers.push_back(OffscreenChanges::Transfer{c, to, destinations});
+    return;
+  }
   Model* from = c->getLevel()->getModel();
   if (from != to && !c->getRider()) {
     if (destinations.empty())
@@ -826,6 +939,10 @@ void Game::uploadEvent(const string& name, const map<string, string>& m) {
 }
 
 void Game::addAnalytics(const string& name, const string& value) {
+  if (offscreenChanges) {
+    offscreenChanges->analytics.push_back({name, value});
+    return;
+  }
   uploadEvent("customEvent", {
     {"name", name},
     {"value", value}
@@ -833,6 +950,10 @@ void Game::addAnalytics(const string& name, const string& value) {
 }
 
 void Game::achieve(AchievementId id) const {
+  if (offscreenChanges) {
+    offscreenChanges->achievements.push_back(id);
+    return;
+  }
   if (steamAchievements)
     steamAchievements->achieve(id);
   if (!unlocks->isAchieved(id)) {
@@ -961,11 +1082,22 @@ void Game::clearPlayerControl() {
 }
 
 void Game::addEvent(const GameEvent& event) {
+  if (offscreenChanges) {
+    // The site's own listeners are notified right away, everything else waits for the end of the update.
+    // Moves only go to PlayerControl if there is one, same as in dispatchEvent().
+    if (!event.contains<EventInfo::CreatureMoved>() || !playerControl)
+      offscreenChanges->model->addEvent(event);
+    offscreenChanges->events.push_back(event);
+  } else
+    dispatchEvent(event, nullptr);
+}
+
+void Game::dispatchEvent(const GameEvent& event, const Model* alreadyNotified) {
   if (event.contains<EventInfo::CreatureMoved>() && !!playerControl)
     playerControl->onEvent(event); // shortcut to optimize because only PlayerControl cares about this event
   else
     for (Vec2 v : models.getBounds())
-      if (models[v])
+      if (models[v] && models[v].get() != alreadyNotified)
         models[v]->addEvent(event);
   using namespace EventInfo;
   event.visit<void>(
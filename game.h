@@ -112,6 +112,12 @@ class Game : public OwnedObject<Game> {
   void addCollective(Collective*);
 
   void addEvent(const GameEvent&);
+  // Active sites other than the current one are simulated every turn on this many worker threads. 0 turns it off,
+  // which is the default. A site's update only changes the site itself. Events, transfers, tribe standings,
+  // achievements and analytics are collected and applied on the calling thread after all sites are done, and each
+  // site draws from its own Random and its own share of the names. Statistics and content id interning are locked,
+  // the ContentFactory is only read. Exceptions thrown by a site's update are rethrown on the calling thread.
+  static void setOffscreenSimulationThreads(int);
   void addAnalytics(const string& name, const string& value);
   void achieve(AchievementId) const;
   void setWasTransfered();
@@ -129,6 +135,8 @@ class Game : public OwnedObject<Game> {
 
   private:
   void tick(GlobalTime);
+  void updateOffscreenModels(GlobalTime);
+  void dispatchEvent(const GameEvent&, const Model* alreadyNotified);
   bool updateModel(Model*, double timeDiff, optional<milliseconds> endTime);
   void uploadEvent(const string& name, const map<string, string>&);
   void considerAchievement(const GameEvent&);
@@ -27,6 +27,56 @@ class PlayerMessage;
 class SpecialTrait;
 class Encyclopedia;
 
+// An immutable vector that copies share, so GameInfo can be filled every frame from cached data without copying
+// the elements. The hash is computed once when the vector is set.
+template <typename T>
+class SharedInfoVector {
+  public:
+  typedef T value_type;
+  typedef typename vector<T>::const_iterator const_iterator;
+
+  SharedInfoVector() {}
+  SharedInfoVector(vector<T> v)
+      : elems(make_shared<const vector<T>>(std::move(v))), hash(combineHash(*elems)) {}
+
+  const vector<T>& get() const {
+    static const vector<T> empty;
+    return elems ? *elems : empty;
+  }
+
+  operator const vector<T>&() const {
+    return get();
+  }
+
+  const_iterator begin() const {
+    return get().begin();
+  }
+
+  const_iterator end() const {
+    return get().end();
+  }
+
+  int size() const {
+    return get().size();
+  }
+
+  bool empty() const {
+    return get().empty();
+  }
+
+  const T& operator[](int index) const {
+    return get()[index];
+  }
+
+  size_t getHash() const {
+    return elems ? hash : combineHash(get());
+  }
+
+  private:
+  shared_ptr<const vector<T>> elems;
+  size_t hash = 0;
+};
+
 struct CreatureInfo {
   CreatureInfo(const Creature*);
   ViewIdList HASH(viewId);
@@ -245,12 +295,12 @@ class CollectiveInfo {
     bool HASH(isBuilding);
     HASH_ALL(viewId, name, cost, count, state, help, key, groupName, hotkeyOpensGroup, tutorialHighlight, isBuilding)
   };
-  vector<Button> HASH(buildings);
+  SharedInfoVector<Button> HASH(buildings);
   string HASH(populationString);
   int HASH(minionCount);
   int HASH(minionLimit);
   string HASH(monsterHeader);
-  vector<CreatureInfo> HASH(minions);
+  SharedInfoVector<CreatureInfo> HASH(minions);
   struct CreatureGroup {
     UniqueEntity<Creature>::Id HASH(creatureId);
     string HASH(name);
@@ -259,8 +309,8 @@ class CollectiveInfo {
     bool HASH(highlight);
     HASH_ALL(creatureId, name, viewId, count, highlight)
   };
-  vector<CreatureGroup> HASH(minionGroups);
-  vector<CreatureGroup> HASH(automatonGroups);
+  SharedInfoVector<CreatureGroup> HASH(minionGroups);
+  SharedInfoVector<CreatureGroup> HASH(automatonGroups);
   struct ChosenCreatureInfo {
     UniqueEntity<Creature>::Id HASH(chosenId);
     vector<PlayerInfo> HASH(creatures);
@@ -269,7 +319,7 @@ class CollectiveInfo {
   };
   optional<ChosenCreatureInfo> HASH(chosenCreature);
   vector<ImmigrantDataInfo> HASH(immigration);
-  vector<ImmigrantDataInfo> HASH(allImmigration);
+  SharedInfoVector<ImmigrantDataInfo> HASH(allImmigration);
   struct QueuedItemInfo {
     double HASH(productionState);
     bool HASH(paid);
@@ -346,7 +396,7 @@ class CollectiveInfo {
     bool HASH(canAdvance);
     HASH_ALL(viewId, name, id, promotions, options, canAdvance)
   };
-  vector<MinionPromotionInfo> HASH(minionPromotions);
+  SharedInfoVector<MinionPromotionInfo> HASH(minionPromotions);
   int HASH(availablePromotions);
   struct Resource {
     ViewId HASH(viewId);
@@ -376,7 +426,7 @@ class CollectiveInfo {
     bool HASH(priority);
     HASH_ALL(name, creature, priority)
   };
-  vector<Task> HASH(taskMap);
+  SharedInfoVector<Task> HASH(taskMap);
 
   struct NextWave {
     ViewIdList HASH(viewId);
@@ -501,6 +501,11 @@ void GuiBuilder::addUpsCounterTick() {
   upsCounter.addTick();
 }
 
+void GuiBuilder::setGuiRebuildStats(steady_clock::duration time, int numCreatedElems) {
+  lastGuiRebuildTime = time;
+  lastGuiRebuildElems = numCreatedElems;
+}
+
 const int resourceSpace = 110;
 
 SGuiElem GuiBuilder::drawResources(const vector<CollectiveInfo::Resource>& numResource,
@@ -550,6 +555,12 @@ SGuiElem GuiBuilder::drawResources(const vector<CollectiveInfo::Resource>& numRe
 
 SGuiElem GuiBuilder::drawBottomBandInfo(GameInfo& gameInfo, int width) {
   auto& info = *gameInfo.playerInfo.getReferenceMaybe<CollectiveInfo>();
+  // The labels read the population, turn and sunlight from gameInfo, so only the resources and the layout
+  // require a rebuild.
+  int hash = combineHash(info.numResource, gameInfo.tutorial, width);
+  if (hash == bottomBandInfoHash && bottomBandInfoCache)
+    return bottomBandInfoCache;
+  bottomBandInfoHash = hash;
   GameSunlightInfo& sunlightInfo = gameInfo.sunlightInfo;
   auto bottomLine = WL(getListBuilder);
   const int space = 55;
@@ -561,10 +572,11 @@ SGuiElem GuiBuilder::drawBottomBandInfo(GameInfo& gameInfo, int width) {
   bottomLine.addElem(getTurnInfoGui(gameInfo.time), 50);
   bottomLine.addSpace(space);
   bottomLine.addElem(getSunlightInfoGui(sunlightInfo), 80);
-  return WL(getListBuilder, legendLineHeight)
+  bottomBandInfoCache = WL(getListBuilder, legendLineHeight)
         .addElem(WL(centerHoriz, drawResources(info.numResource, gameInfo.tutorial, width)))
         .addElem(WL(centerHoriz, bottomLine.buildHorizontalList()))
         .buildVerticalList();
+  return bottomBandInfoCache;
 }
 
 const char* GuiBuilder::getGameSpeedName(GuiBuilder::GameSpeed gameSpeed) const {
@@ -704,9 +716,18 @@ SGuiElem GuiBuilder::drawRightBandInfo(GameInfo& info) {
               return "LAT " + toString(fpsCounter.getMaxLatency()) + "ms / " + toString(upsCounter.getMaxLatency()) + "ms";
             case CounterMode::SMOD:
               return "SMOD " + toString(modifiedSquares) + "/" + toString(totalSquares);
+            case CounterMode::GUI:
+              return "GUI " + toString(lastGuiRebuildElems) + " / " +
+                  toString(duration_cast<microseconds>(lastGuiRebuildTime).count() / 1000.0) + "ms";
+            case CounterMode::DRAW: {
+              auto& stats = renderer.getLastFrameStats();
+              return "DRAW " + toString(stats.drawCalls) + " / " + toString((int) stats.cpuTimeMs) + "ms / TXT " +
+                  toString(stats.textLookups > 0
+                      ? 100 * (stats.textLookups - stats.textCacheMisses) / stats.textLookups : 100) + "%";
+            }
           }
         }, Color::WHITE),
-        WL(button, [=]() { counterMode = (CounterMode) ( ((int) counterMode + 1) % 4); })), 120);
+        WL(button, [=]() { counterMode = (CounterMode) ( ((int) counterMode + 1) % 6); })), 120);
     main = WL(margin, WL(leftMargin, 10, bottomLine.buildHorizontalList()),
         std::move(main), 18, gui.BOTTOM);
     rightBandInfoCache = WL(margin, std::move(butGui), std::move(main), 55, gui.TOP);
@@ -1309,14 +1330,19 @@ vector<SGuiElem> GuiBuilder::drawPlayerAttributes(const ViewObject::CreatureAttr
 
 SGuiElem GuiBuilder::drawBottomPlayerInfo(const GameInfo& gameInfo) {
   auto& info = *gameInfo.playerInfo.getReferenceMaybe<PlayerInfo>();
-  return WL(getListBuilder, legendLineHeight)
-      .addElem(WL(centerHoriz, WL(horizontalList,
-           drawPlayerAttributes(gameInfo.playerInfo.getReferenceMaybe<PlayerInfo>()->attributes), resourceSpace)))
+  // The turn and sunlight labels read gameInfo when rendered.
+  int hash = combineHash(info.attributes);
+  if (hash == bottomPlayerInfoHash && bottomPlayerInfoCache)
+    return bottomPlayerInfoCache;
+  bottomPlayerInfoHash = hash;
+  bottomPlayerInfoCache = WL(getListBuilder, legendLineHeight)
+      .addElem(WL(centerHoriz, WL(horizontalList, drawPlayerAttributes(info.attributes), resourceSpace)))
       .addElem(WL(centerHoriz, WL(getListBuilder)
           .addElem(getTurnInfoGui(gameInfo.time), 90)
           .addElem(getSunlightInfoGui(gameInfo.sunlightInfo), 140)
           .buildHorizontalList()))
       .buildVerticalList();
+  return bottomPlayerInfoCache;
 }
 
 static int viewObjectWidth = 27;
@@ -3721,6 +3747,15 @@ static void cutToFit(Renderer& renderer, string& s, int maxLength) {
 }
 
 SGuiElem GuiBuilder::drawMessages(const vector<PlayerMessage>& messageBuffer, int maxMessageLength) {
+  int hash = combineHash(messageBuffer, maxMessageLength);
+  if (hash == messagesHash && messagesCache)
+    return messagesCache;
+  messagesHash = hash;
+  messagesCache = drawMessagesImpl(messageBuffer, maxMessageLength);
+  return messagesCache;
+}
+
+SGuiElem GuiBuilder::drawMessagesImpl(const vector<PlayerMessage>& messageBuffer, int maxMessageLength) {
   int hMargin = 10;
   int vMargin = 5;
   vector<vector<PlayerMessage>> messages = fitMessages(renderer, messageBuffer, maxMessageLength - 2 * hMargin,
@@ -116,6 +116,7 @@ class GuiBuilder {
 
   void addFpsCounterTick();
   void addUpsCounterTick();
+  void setGuiRebuildStats(steady_clock::duration, int numCreatedElems);
   void closeOverlayWindows();
   bool isEnlargedMinimap() const;
   void toggleEnlargedMinimap();
@@ -203,6 +204,12 @@ class GuiBuilder {
   optional<Vec2> creatureListIndex;
   int rightBandInfoHash = 0;
   SGuiElem rightBandInfoCache;
+  int bottomBandInfoHash = 0;
+  SGuiElem bottomBandInfoCache;
+  int bottomPlayerInfoHash = 0;
+  SGuiElem bottomPlayerInfoCache;
+  int messagesHash = 0;
+  SGuiElem messagesCache;
   SGuiElem immigrationCache;
   int immigrationHash = 0;
   optional<string> activeGroup;
@@ -251,10 +258,13 @@ class GuiBuilder {
   const char* getCurrentGameSpeedName() const;
 
   FpsCounter fpsCounter, upsCounter;
-  enum class CounterMode { NONE, FPS, LAT, SMOD };
+  enum class CounterMode { NONE, FPS, LAT, SMOD, DRAW, GUI };
   CounterMode counterMode = CounterMode::NONE;
+  steady_clock::duration lastGuiRebuildTime;
+  int lastGuiRebuildElems = 0;
 
   SGuiElem getButtonLine(CollectiveInfo::Button, int num, const optional<TutorialInfo>&);
+  SGuiElem drawMessagesImpl(const vector<PlayerMessage>&, int guiLength);
   SGuiElem drawMinionsOverlay(const CollectiveInfo::ChosenCreatureInfo&, const optional<TutorialInfo>&);
   SGuiElem minionsOverlayCache;
   int minionsOverlayHash = 0;
@@ -62,6 +62,7 @@ optional<Vec2> GuiElem::getPreferredSize() {
 
 static map<int, int> lineNumbers;
 static int totalGuiElems = 0;
+static int createdGuiElems = 0;
 
 void dumpGuiLineNumbers(ostream& o) {
   o << "Total elems " << totalGuiElems << "\n";
@@ -81,6 +82,11 @@ GuiElem::~GuiElem() {
 
 GuiElem::GuiElem() {
   ++totalGuiElems;
+  ++createdGuiElems;
+}
+
+int getNumCreatedGuiElems() {
+  return createdGuiElems;
 }
 
 void GuiElem::setLineNumber(int l) {
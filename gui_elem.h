@@ -36,6 +36,8 @@ struct ScriptedUIData;
 struct ScriptedUIState;
 
 void dumpGuiLineNumbers(ostream&);
+// Number of GuiElems created since the start of the program.
+int getNumCreatedGuiElems();
 
 class GuiElem {
   public:
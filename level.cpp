@@ -48,6 +48,8 @@
 #include "player_control.h"
 #include "portals.h"
 #include "effect_type.h"
+#include "sim_benchmark.h"
+#include "shortest_path.h"
 #include "content_factory.h"
 
 template <class Archive>
@@ -197,56 +199,114 @@ void Level::removeLightSource(Vec2 pos, double radius) {
   addLightSource(pos, radius, -1);
 }
 
-void Level::addLightSource(Vec2 pos, double radius, int numLight) {
-  PROFILE;
-  if (radius > 0) {
-    for (Vec2 v : getVisibleTilesNoDarkness(pos, VisionId::NORMAL)) {
-      double dist = (v - pos).lengthD();
-      if (dist <= radius) {
-        lightAmount[v] += min(1.0, 1 - (dist) / radius) * numLight;
-        setNeedsRenderUpdate(v, true);
-      }
+// Light falloff around a source, indexed by the offset from the source.
+static const Table<double>& getLightKernel(double radius) {
+  // There are only a few different light radii. Levels can be simulated on worker threads, so each thread keeps
+  // its own kernels.
+  thread_local unordered_map<double, Table<double>> kernels;
+  auto it = kernels.find(radius);
+  if (it == kernels.end()) {
+    int size = (int) radius;
+    Table<double> kernel(Rectangle(-size, -size, size + 1, size + 1), 0);
+    for (Vec2 v : kernel.getBounds()) {
+      double dist = v.lengthD();
+      if (dist <= radius)
+        kernel[v] = min(1.0, 1 - dist / radius);
     }
+    it = kernels.emplace(radius, std::move(kernel)).first;
   }
+  return it->second;
 }
 
-void Level::addDarknessSource(Vec2 pos, double radius, int numDarkness) {
-  if (radius > 0) {
-    for (Vec2 v : getVisibleTilesNoDarkness(pos, VisionId::NORMAL)) {
-      double dist = (v - pos).lengthD();
-      if (dist <= radius) {
-        lightCapAmount[v] -= min(1.0, 1 - (dist) / radius) * numDarkness;
-        setNeedsRenderUpdate(v, true);
-      }
-//      updateConnectivity(v);
+void Level::addLight(Table<double>& amount, Vec2 pos, double radius, double mult) {
+  auto& kernel = getLightKernel(radius);
+  auto visible = getVisibleTilesNoDarkness(pos, VisionId::NORMAL);
+  for (Vec2 v : *visible) {
+    Vec2 offset = v - pos;
+    if (offset.inRectangle(kernel.getBounds()) && kernel[offset] > 0) {
+      amount[v] += kernel[offset] * mult;
+      setNeedsRenderUpdate(v, true);
     }
   }
 }
 
+void Level::moveLight(Table<double>& amount, Vec2 from, Vec2 to, double radius, double mult) {
+  auto& kernel = getLightKernel(radius);
+  auto& kernelBounds = kernel.getBounds();
+  // Sums up the change first, so that squares lit the same way from both positions aren't touched.
+  Table<double> delta(Rectangle(
+      Vec2(min(from.x, to.x), min(from.y, to.y)) + kernelBounds.topLeft(),
+      Vec2(max(from.x, to.x), max(from.y, to.y)) + kernelBounds.bottomRight()), 0);
+  auto visibleFrom = getVisibleTilesNoDarkness(from, VisionId::NORMAL);
+  for (Vec2 v : *visibleFrom) {
+    Vec2 offset = v - from;
+    if (offset.inRectangle(kernelBounds))
+      delta[v] -= kernel[offset] * mult;
+  }
+  auto visibleTo = getVisibleTilesNoDarkness(to, VisionId::NORMAL);
+  for (Vec2 v : *visibleTo) {
+    Vec2 offset = v - to;
+    if (offset.inRectangle(kernelBounds))
+      delta[v] += kernel[offset] * mult;
+  }
+  for (Vec2 v : delta.getBounds())
+    if (delta[v] != 0) {
+      amount[v] += delta[v];
+      setNeedsRenderUpdate(v, true);
+    }
+}
+
+void Level::addLightSource(Vec2 pos, double radius, int numLight) {
+  PROFILE;
+  if (radius > 0)
+    addLight(lightAmount, pos, radius, numLight);
+}
+
+void Level::addDarknessSource(Vec2 pos, double radius, int numDarkness) {
+  if (radius > 0)
+    addLight(lightCapAmount, pos, radius, -numDarkness);
+}
+
+static bool isDarknessSource(const Creature* c) {
+  return c->isAffected(LastingEffect::DARKNESS_SOURCE);
+}
+
+static bool isLightSource(const Creature* c) {
+  return c->isAffected(LastingEffect::LIGHT_SOURCE) || c->isAffected(LastingEffect::ON_FIRE);
+}
+
 void Level::updateCreatureLight(Vec2 pos, int diff) {
   auto square = squares->getReadonly(pos);
   CHECK(square) << pos << " " << getBounds();
   if (Creature* c = square->getCreature()) {
-    if (c->isAffected(LastingEffect::DARKNESS_SOURCE))
+    if (isDarknessSource(c))
       addDarknessSource(pos, getCreatureLightRadius(), diff);
-    if (c->isAffected(LastingEffect::LIGHT_SOURCE) || c->isAffected(LastingEffect::ON_FIRE))
+    if (isLightSource(c))
       addLightSource(pos, getCreatureLightRadius(), diff);
   }
 }
 
+void Level::moveCreatureLight(const Creature* c, Vec2 from, Vec2 to) {
+  PROFILE;
+  if (isDarknessSource(c))
+    moveLight(lightCapAmount, from, to, getCreatureLightRadius(), -1);
+  if (isLightSource(c))
+    moveLight(lightAmount, from, to, getCreatureLightRadius(), 1);
+}
+
 void Level::updateVisibility(Vec2 changedSquare) {
   auto allVisible = getVisibleTilesNoDarkness(changedSquare, VisionId::NORMAL);
-  for (Vec2 pos : allVisible) {
+  for (Vec2 pos : *allVisible) {
     addLightSource(pos, Position(pos, this).getLightEmission(), -1);
     updateCreatureLight(pos, -1);
   }
   for (VisionId vision : ENUM_ALL(VisionId))
     getFieldOfView(vision).squareChanged(changedSquare);
-  for (Vec2 pos : allVisible) {
+  for (Vec2 pos : *allVisible) {
     addLightSource(pos, Position(pos, this).getLightEmission(), 1);
     updateCreatureLight(pos, 1);
   }
-  for (Vec2 pos : allVisible)
+  for (Vec2 pos : *allVisible)
     getModel()->addEvent(EventInfo::VisibilityChanged{Position(pos, this)});
 }
 
@@ -454,8 +514,8 @@ bool Level::canSee(Vec2 from, Vec2 to, const Vision& vision) const {
 
 void Level::moveCreature(Creature* creature, Vec2 direction) {
   Vec2 position = creature->getPosition().getCoord();
-  unplaceCreature(creature, position);
-  placeCreature(creature, position + direction);
+  unplaceCreature(creature, position, true);
+  placeCreature(creature, position + direction, position);
 }
 
 template <typename Fun>
@@ -480,11 +540,12 @@ void Level::placeSwarmer(Vec2 pos, Creature* c) {
     map.second.addElement(pos + Vec2(map.first, map.first), c);
 }
 
-void Level::unplaceCreature(Creature* creature, Vec2 pos) {
+void Level::unplaceCreature(Creature* creature, Vec2 pos, bool keepLight) {
   bucketMap->removeElement(pos, creature);
   if (creature->isAffected(LastingEffect::SWARMER))
     unplaceSwarmer(pos, creature);
-  updateCreatureLight(pos, -1);
+  if (!keepLight)
+    updateCreatureLight(pos, -1);
   modSafeSquare(pos)->removeCreature(Position(pos, this));
   model->increaseMoveCounter();
   forEachEffect(pos, creature->getTribeId(),
@@ -495,7 +556,7 @@ void Level::unplaceCreature(Creature* creature, Vec2 pos) {
         c->updateViewObjectFlanking();
 }
 
-void Level::placeCreature(Creature* creature, Vec2 pos) {
+void Level::placeCreature(Creature* creature, Vec2 pos, optional<Vec2> movedFrom) {
   auto prevPos = creature->getPosition();
   Position position(pos, this);
   creature->setPosition(position);
@@ -503,7 +564,10 @@ void Level::placeCreature(Creature* creature, Vec2 pos) {
   if (creature->isAffected(LastingEffect::SWARMER))
     placeSwarmer(pos, creature);
   modSafeSquare(pos)->putCreature(creature);
-  updateCreatureLight(pos, 1);
+  if (movedFrom)
+    moveCreatureLight(creature, *movedFrom, pos);
+  else
+    updateCreatureLight(pos, 1);
   position.onEnter(creature);
   model->increaseMoveCounter();
   int numEffects = 0;
@@ -533,14 +597,14 @@ void Level::swapCreatures(Creature* c1, Creature* c2) {
   placeCreature(c2, pos1);
 }
 
-const vector<SVec2>& Level::getVisibleTilesNoDarkness(Vec2 pos, VisionId vision) const {
+shared_ptr<const vector<SVec2>> Level::getVisibleTilesNoDarkness(Vec2 pos, VisionId vision) const {
   PROFILE;
   return getFieldOfView(vision).getVisibleTiles(pos);
 }
 
 vector<Vec2> Level::getVisibleTiles(Vec2 pos, const Vision& vision) const {
   return getFieldOfView(vision.getId()).getVisibleTiles(pos)
-      .transform([](auto v) { return Vec2(v);})
+      ->transform([](auto v) { return Vec2(v);})
       .filter([&](Vec2 v) { return isWithinVision(pos, v, vision); });
 }
 
@@ -582,6 +646,7 @@ void Level::addBurningFurniture(Vec2 pos, FurnitureLayer layer) {
 
 void Level::tick() {
   PROFILE_BLOCK("Level::tick");
+  BENCHMARK_PHASE(LEVEL_TICK);
   for (Vec2 pos : tickingSquares)
     squares->getWritable(pos)->tick(Position(pos, this));
   auto& furnitureFactory = getGame()->getContentFactory()->furniture;
@@ -676,6 +741,17 @@ Sectors& Level::getSectors(const MovementType& movement) const {
   }
 }
 
+FlowFieldCache& Level::getFlowFields() const {
+  return *flowFields;
+}
+
+FieldOfViewCacheStats Level::getVisibilityCacheStats() const {
+  FieldOfViewCacheStats ret;
+  for (auto vision : ENUM_ALL(VisionId))
+    ret += (*fieldOfView)[vision].getCacheStats();
+  return ret;
+}
+
 void Level::prepareForRetirement() {
   for (auto l : ENUM_ALL(FurnitureLayer))
     furniture->getBuilt(l).clearModified();
@@ -685,6 +761,7 @@ void Level::updateSunlightMovement() {
   for (auto movement : getKeys(sectors))
     if (movement.isSunlightVulnerable())
       sectors.erase(movement);
+  flowFields->clear();
 }
 
 int Level::getNumGeneratedSquares() const {
@@ -710,7 +787,23 @@ bool Level::needsRenderUpdate(Vec2 pos) const {
 }
 
 void Level::setNeedsRenderUpdate(Vec2 pos, bool s) {
-  renderUpdates[pos] = s;
+  if (renderUpdates[pos] != s) {
+    renderUpdates[pos] = s;
+    renderUpdateCount[pos / renderChunkSize] += s ? 1 : -1;
+  }
+}
+
+bool Level::chunkNeedsRenderUpdate(Vec2 pos) const {
+  return renderUpdateCount[pos / renderChunkSize] > 0;
+}
+
+Table<int> Level::getInitialRenderUpdateCount() {
+  auto bounds = getMaxBounds();
+  Table<int> ret(Rectangle((bounds.width() + renderChunkSize - 1) / renderChunkSize,
+      (bounds.height() + renderChunkSize - 1) / renderChunkSize), 0);
+  for (Vec2 v : bounds)
+    ++ret[v / renderChunkSize];
+  return ret;
 }
 
 bool Level::needsMemoryUpdate(Vec2 pos) const {
@@ -44,7 +44,9 @@ class SquareArray;
 class FurnitureArray;
 class Vision;
 class FieldOfView;
+struct FieldOfViewCacheStats;
 class ContentFactory;
+class FlowFieldCache;
 struct PhylacteryInfo;
 
 /** A class representing a single level of the dungeon or the overworld. All events occuring on the level are performed by this class.*/
@@ -149,11 +151,17 @@ class Level : public OwnedObject<Level> {
   bool needsMemoryUpdate(Vec2) const;
   bool needsRenderUpdate(Vec2) const;
   void setNeedsRenderUpdate(Vec2, bool);
+  // Positions that need a render update are also counted in square chunks of this size, so that the map can skip
+  // chunks that didn't change.
+  static constexpr int renderChunkSize = 16;
+  bool chunkNeedsRenderUpdate(Vec2) const;
 
   LevelId getUniqueId() const;
   void setFurniture(Vec2, PFurniture);
 
   Sectors& getSectors(const MovementType&) const;
+  FlowFieldCache& getFlowFields() const;
+  FieldOfViewCacheStats getVisibilityCacheStats() const;
   struct EffectSet {
     vector<LastingOrBuff> SERIAL(friendly);
     vector<LastingOrBuff> SERIAL(hostile);
@@ -184,13 +192,16 @@ class Level : public OwnedObject<Level> {
   HeapAllocated<FurnitureArray> SERIAL(furniture);
   Table<bool> SERIAL(memoryUpdates);
   Table<bool> renderUpdates = Table<bool>(getMaxBounds(), true);
+  static Table<int> getInitialRenderUpdateCount();
+  Table<int> renderUpdateCount = getInitialRenderUpdateCount();
   Table<bool> SERIAL(unavailable);
   LandingSquares SERIAL(landingSquares);
   set<Vec2> SERIAL(tickingSquares);
   HashMap<pair<Vec2, FurnitureLayer>, double> tickingFurniture;
   HashSet<pair<Vec2, FurnitureLayer>> burningFurniture;
-  void placeCreature(Creature*, Vec2 pos);
-  void unplaceCreature(Creature*, Vec2 pos);
+  // When moving a creature, its light is moved after placing it, instead of being removed and added again.
+  void placeCreature(Creature*, Vec2 pos, optional<Vec2> movedFrom = none);
+  void unplaceCreature(Creature*, Vec2 pos, bool keepLight = false);
   vector<Creature*> SERIAL(creatures);
   EntitySet<Creature> SERIAL(creatureIds);
   Model* SERIAL(model) = nullptr;
@@ -203,6 +214,7 @@ class Level : public OwnedObject<Level> {
   Table<double> SERIAL(lightCapAmount);
   EnumMap<TribeId::KeyType, unique_ptr<EffectsTable>> SERIAL(furnitureEffects);
   mutable HashMap<MovementType, Sectors> sectors;
+  mutable HeapAllocated<FlowFieldCache> flowFields;
   Sectors& getSectorsDontCreate(const MovementType&) const;
 
   friend class LevelBuilder;
@@ -217,12 +229,15 @@ class Level : public OwnedObject<Level> {
   private:
   void addLightSource(Vec2 pos, double radius, int numLight);
   void addDarknessSource(Vec2 pos, double radius, int numLight);
+  void addLight(Table<double>& amount, Vec2 pos, double radius, double mult);
+  void moveLight(Table<double>& amount, Vec2 from, Vec2 to, double radius, double mult);
   FieldOfView& getFieldOfView(VisionId vision) const;
-  const vector<SVec2>& getVisibleTilesNoDarkness(Vec2 pos, VisionId vision) const;
+  shared_ptr<const vector<SVec2>> getVisibleTilesNoDarkness(Vec2 pos, VisionId vision) const;
   bool isWithinVision(Vec2 from, Vec2 to, const Vision&) const;
   LevelId SERIAL(levelId) = 0;
   bool SERIAL(noDiagonalPassing) = false;
   void updateCreatureLight(Vec2, int diff);
+  void moveCreatureLight(const Creature*, Vec2 from, Vec2 to);
   template<typename Fun>
   void forEachEffect(Vec2, TribeId, Fun);
   void placeSwarmer(Vec2, Creature*);
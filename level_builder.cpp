@@ -198,7 +198,7 @@ PLevel LevelBuilder::build(const ContentFactory* factory, Model* m, LevelMaker*
     pos.addCreature(std::move(c.first));*/
     // Use landCreature instead, because it will try to put it in adjacent positions
     if (!l->landCreature({pos}, c.first.get()))
-      throw LevelGenException();
+      throw LevelGenException("LevelBuilder");
     m->addCreature(std::move(c.first));
   }
   for (CollectiveBuilder* c : collectives)
@@ -56,13 +56,13 @@
 
 namespace {
 
-void failGen() {
-  throw LevelGenException();
+void failGen(const char* maker) {
+  throw LevelGenException(maker);
 }
 
-void checkGen(bool b) {
+void checkGen(bool b, const char* maker) {
   if (!b)
-    failGen();
+    failGen(maker);
 }
 
 class Predicate {
@@ -71,61 +71,83 @@ class Predicate {
     return predFun(builder, pos);
   }
 
+  // Predicates with the same key match the same squares, so their counts can be shared.
+  const optional<string>& getKey() const {
+    return key;
+  }
+
+  optional<bool> getConstant() const {
+    if (key && *key == "true")
+      return true;
+    if (key && *key == "false")
+      return false;
+    return none;
+  }
+
   Vec2 getRandomPosition(LevelBuilder* builder, Rectangle area) {
     vector<Vec2> good;
     for (Vec2 v : area)
       if (apply(builder, v))
         good.push_back(v);
     if (good.empty())
-      failGen();
+      failGen("Predicate");
     return builder->getRandom().choose(good);
   }
 
   static Predicate attrib(SquareAttrib attr) {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->hasAttrib(pos, attr);});
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->hasAttrib(pos, attr);},
+        "attrib "_s + EnumInfo<SquareAttrib>::getString(attr));
   }
 
   static Predicate hasAnyItems() {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->hasAnyItems(pos);});
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->hasAnyItems(pos);}, "items"_s);
   }
 
   Predicate operator !() const {
     PredFun self(predFun);
-    return Predicate([self] (LevelBuilder* builder, Vec2 pos) { return !self(builder, pos);});
+    return Predicate([self] (LevelBuilder* builder, Vec2 pos) { return !self(builder, pos);},
+        key.map([](const string& k) { return "!(" + k + ")"; }));
   }
 
   Predicate operator && (const Predicate& p1) const {
     PredFun self(predFun);
     return Predicate([self, p1] (LevelBuilder* builder, Vec2 pos) {
-        return p1.apply(builder, pos) && self(builder, pos);});
+        return p1.apply(builder, pos) && self(builder, pos);}, combineKeys(key, "&&", p1.key));
   }
 
   Predicate operator || (const Predicate& p1) const {
     PredFun self(predFun);
     return Predicate([=] (LevelBuilder* builder, Vec2 pos) {
-        return p1.apply(builder, pos) || self(builder, pos);});
+        return p1.apply(builder, pos) || self(builder, pos);}, combineKeys(key, "||", p1.key));
   }
 
   static Predicate type(FurnitureType t) {
     return Predicate([=] (LevelBuilder* builder, Vec2 pos) {
-      return builder->isFurnitureType(pos, t);});
+      return builder->isFurnitureType(pos, t);}, "type "_s + t.data());
   }
 
   static Predicate inRectangle(Rectangle r) {
     return Predicate([=] (LevelBuilder* builder, Vec2 pos) {
-      return pos.inRectangle(r);});
+      return pos.inRectangle(r);}, "rect "_s + toString(r));
   }
 
   static Predicate alwaysTrue() {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return true;});
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return true;}, "true"_s);
   }
 
   static Predicate alwaysFalse() {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return false;});
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return false;}, "false"_s);
   }
 
   static Predicate canEnter(MovementType m) {
-    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->canNavigate(pos, m);});
+    optional<string> key;
+    // Only plain movement types get a key, the rest can't be told apart from outside.
+    if (m == MovementType(m.getTraits())) {
+      key = "canEnter"_s;
+      for (auto trait : m.getTraits())
+        *key += " "_s + EnumInfo<MovementTrait>::getString(trait);
+    }
+    return Predicate([=] (LevelBuilder* builder, Vec2 pos) { return builder->canNavigate(pos, m);}, key);
   }
 
   static Predicate near8AtLeast(FurnitureType type, int count) {
@@ -135,7 +157,7 @@ class Predicate {
         if (builder->isFurnitureType(v, type))
           --cnt;
       return cnt <= 0;
-    });
+    }, "near8AtLeast "_s + type.data() + " " + toString(count));
   }
 
   static Predicate near4AtLeast(FurnitureType type, int count) {
@@ -145,7 +167,7 @@ class Predicate {
         if (builder->isFurnitureType(v, type))
           --cnt;
       return cnt <= 0;
-    });
+    }, "near4AtLeast "_s + type.data() + " " + toString(count));
   }
 
   static Predicate near4Equals(FurnitureType type, int count) {
@@ -155,13 +177,21 @@ class Predicate {
         if (builder->isFurnitureType(v, type))
           --cnt;
       return cnt == 0;
-    });
+    }, "near4Equals "_s + type.data() + " " + toString(count));
   }
 
   private:
   typedef function<bool(LevelBuilder*, Vec2)> PredFun;
-  Predicate(PredFun fun) : predFun(fun) {}
+  Predicate(PredFun fun, optional<string> key) : predFun(fun), key(std::move(key)) {}
+
+  static optional<string> combineKeys(const optional<string>& k1, const char* op, const optional<string>& k2) {
+    if (k1 && k2)
+      return "(" + *k1 + ") " + op + " (" + *k2 + ")";
+    return none;
+  }
+
   PredFun predFun;
+  optional<string> key;
 };
 
 class SquareChange {
@@ -414,7 +444,7 @@ class Connector : public LevelMaker {
         CHECK(builder->canNavigate(v, {MovementTrait::WALK}));
       }
       if (!path.isReachable(v))
-        failGen();
+        failGen("Connector");
     }
   }
 
@@ -475,7 +505,7 @@ class Furnitures : public LevelMaker {
       if (predicate.apply(builder, v) && builder->canPutFurniture(v, FurnitureLayer::MIDDLE))
         available.push_back(v);
     for (int i : Range(max<int>(furnitureList.numUnique(), available.size() * density))) {
-      checkGen(!available.empty());
+      checkGen(!available.empty(), "Furnitures");
       Vec2 pos = builder->getRandom().choose(available);
       builder->putFurniture(pos, furnitureList, tribe);
       if (attr)
@@ -511,7 +541,7 @@ class Inhabitants : public LevelMaker {
       for (auto v : area)
         if (builder->canPutCreature(v, creature.get()) && onPred.apply(builder, v))
           positions.push_back(v);
-      checkGen(!positions.empty());
+      checkGen(!positions.empty(), "Inhabitants");
       auto pos = builder->getRandom().choose(positions);
       if (collective) {
         collective->addCreature(creature.get(), minion.second);
@@ -547,7 +577,7 @@ class Corpses : public LevelMaker {
         pos = Vec2(builder->getRandom().get(area.left(), area.right()),
             builder->getRandom().get(area.top(), area.bottom()));
       } while (--numTries > 0 && (!builder->canPutItems(pos) || (!onPred.apply(builder, pos))));
-      checkGen(numTries > 0);
+      checkGen(numTries > 0, "Corpses");
       if (builder->getRandom().roll(10))
         builder->putItems(pos, creature->getEquipment().removeAllItems(creature.get(), factory));
       builder->putItems(pos, creature->generateCorpse(builder->getContentFactory(), nullptr, true));
@@ -590,7 +620,7 @@ class Creatures : public LevelMaker {
         pos = Vec2(builder->getRandom().get(area.left(), area.right()),
             builder->getRandom().get(area.top(), area.bottom()));
       } while (--numTries > 0 && (!builder->canPutCreature(pos, creature.get()) || (!onPred.apply(builder, pos))));
-      checkGen(numTries > 0);
+      checkGen(numTries > 0, "Creatures");
       builder->putCreature(pos, std::move(creature));
       taken[pos] = 1;
     }
@@ -617,7 +647,7 @@ class Items : public LevelMaker {
       if (predicate.apply(builder, v) && builder->canNavigate(v, MovementTrait::WALK) &&
           (placeOnFurniture || !builder->getFurniture(v, FurnitureLayer::MIDDLE)))
         available.push_back(v);
-    checkGen(!available.empty());
+    checkGen(!available.empty(), "Items");
     auto itemList = getItems(builder);
     for (int i : Range(numItem))
       builder->putItems(builder->getRandom().choose(available),
@@ -990,7 +1020,7 @@ class Buildings : public LevelMaker {
       } while (!spaceOk && --cnt > 0);
       if (cnt == 0) {
         if (i < minBuildings)
-          failGen(); // "Failed to add " << minBuildings - i << " buildings out of " << minBuildings;
+          failGen("Buildings"); // "Failed to add " << minBuildings - i << " buildings out of " << minBuildings;
         else
           break;
       }
@@ -1070,28 +1100,58 @@ class MakerQueue : public LevelMaker {
   vector<PLevelMaker> makers;
 };
 
+// Number of squares matching a predicate in any rectangle inside the area, using a summed-area table.
 class PredicatePrecalc {
   public:
   PredicatePrecalc(const Predicate& predicate, LevelBuilder* builder, Rectangle area)
-      : counts(Rectangle(area.topLeft(), area.bottomRight() + Vec2(1, 1))) {
-    int px = counts.getBounds().left();
-    int py = counts.getBounds().top();
-    for (int x : Range(px, counts.getBounds().right()))
-      counts[x][py] = 0;
-    for (int y : Range(py, counts.getBounds().bottom()))
-      counts[px][y] = 0;
-    for (Vec2 v : Rectangle(area.topLeft() + Vec2(1, 1), counts.getBounds().bottomRight()))
-      counts[v] = (predicate.apply(builder, v - Vec2(1, 1)) ? 1 : 0) +
-        counts[v.x - 1][v.y] + counts[v.x][v.y - 1] -counts[v.x - 1][v.y - 1];
+      : constant(predicate.getConstant()) {
+    if (constant)
+      return;
+    counts = Table<int>(Rectangle(area.topLeft(), area.bottomRight() + Vec2(1, 1)));
+    int px = counts->getBounds().left();
+    int py = counts->getBounds().top();
+    for (int x : Range(px, counts->getBounds().right()))
+      (*counts)[x][py] = 0;
+    for (int y : Range(py, counts->getBounds().bottom()))
+      (*counts)[px][y] = 0;
+    for (Vec2 v : Rectangle(area.topLeft() + Vec2(1, 1), counts->getBounds().bottomRight()))
+      (*counts)[v] = (predicate.apply(builder, v - Vec2(1, 1)) ? 1 : 0) +
+        (*counts)[v.x - 1][v.y] + (*counts)[v.x][v.y - 1] - (*counts)[v.x - 1][v.y - 1];
   }
 
   int getCount(Rectangle area) const {
-    return counts[area.bottomRight()] + counts[area.topLeft()]
-      -counts[area.bottomLeft()] - counts[area.topRight()];
+    if (constant)
+      return *constant ? area.width() * area.height() : 0;
+    return (*counts)[area.bottomRight()] + (*counts)[area.topLeft()]
+      -(*counts)[area.bottomLeft()] - (*counts)[area.topRight()];
+  }
+
+  private:
+  optional<bool> constant;
+  optional<Table<int>> counts;
+};
+
+// Counts computed for one area, shared by predicates with the same key.
+class PredicateIndex {
+  public:
+  PredicateIndex(LevelBuilder* builder, Rectangle area) : builder(builder), area(area) {}
+
+  const PredicatePrecalc& get(const Predicate& predicate) {
+    if (auto& key = predicate.getKey()) {
+      auto& ret = byKey[*key];
+      if (!ret)
+        ret = make_unique<PredicatePrecalc>(predicate, builder, area);
+      return *ret;
+    }
+    withoutKey.push_back(make_unique<PredicatePrecalc>(predicate, builder, area));
+    return *withoutKey.back();
   }
 
   private:
-  Table<int> counts;
+  LevelBuilder* builder;
+  Rectangle area;
+  map<string, unique_ptr<PredicatePrecalc>> byKey;
+  vector<unique_ptr<PredicatePrecalc>> withoutKey;
 };
 
 class RandomLocations : public LevelMaker {
@@ -1118,25 +1178,25 @@ class RandomLocations : public LevelMaker {
 
     class Precomputed {
       public:
-      Precomputed(LevelBuilder* builder, Rectangle area, Predicate p1, Predicate p2, int minSec, int maxSec)
-        : pred1(p1, builder, area), pred2(p2, builder, area), minSecond(minSec), maxSecond(maxSec) {
+      Precomputed(PredicateIndex& index, const Predicate& p1, const Predicate& p2, int minSec, int maxSec)
+        : pred1(&index.get(p1)), pred2(&index.get(p2)), minSecond(minSec), maxSecond(maxSec) {
       }
 
       bool apply(Rectangle rect) const {
-        int numFirst = pred1.getCount(rect);
-        int numSecond = pred2.getCount(rect);
+        int numFirst = pred1->getCount(rect);
+        int numSecond = pred2->getCount(rect);
         return numSecond >= minSecond && numSecond < maxSecond && numSecond + numFirst == rect.width() * rect.height();
       }
 
       private:
-      PredicatePrecalc pred1;
-      PredicatePrecalc pred2;
+      const PredicatePrecalc* pred1;
+      const PredicatePrecalc* pred2;
       int minSecond;
       int maxSecond;
     };
 
-    Precomputed precompute(LevelBuilder* builder, Rectangle area) const {
-      return Precomputed(builder, area, predicate, second, minSecond, maxSecond);
+    Precomputed precompute(PredicateIndex& index) const {
+      return Precomputed(index, predicate, second, minSecond, maxSecond);
     }
 
     private:
@@ -1194,20 +1254,15 @@ class RandomLocations : public LevelMaker {
     return insideMakers.back().get();
   }
 
-  pair<vector<Vec2>, LevelBuilder::Rot> getAllowedPositions(LevelBuilder* builder, Rectangle area, LevelMaker* maker,
-      const LocationPredicate& predicate, Vec2 size) {
-    auto rotation = builder->getRandom().choose(
-          LevelBuilder::CW0, LevelBuilder::CW1, LevelBuilder::CW2, LevelBuilder::CW3);
-    auto precomputed = predicate.precompute(builder, area);
+  vector<Vec2> getAllowedPositions(Rectangle area, LevelMaker* maker, const LocationPredicate::Precomputed& predicate,
+      Vec2 size) {
     vector<Vec2> pos;
     const int margin = getValueMaybe(minMargin, maker).value_or(0);
-    if (contains({LevelBuilder::CW1, LevelBuilder::CW3}, rotation))
-      std::swap(size.x, size.y);
     for (auto v : Rectangle(area.left() + margin, area.top() + margin,
         area.right() - margin - size.x, area.bottom() - margin - size.y))
-      if (precomputed.apply(Rectangle(v, v + size)))
+      if (predicate.apply(Rectangle(v, v + size)))
         pos.push_back(v);
-    return make_pair(pos, rotation);
+    return pos;
   }
 
   virtual void make(LevelBuilder* builder, Rectangle area) override {
@@ -1217,16 +1272,27 @@ class RandomLocations : public LevelMaker {
     vector<LevelBuilder::Rot> rotations;
     {
       PROFILE_BLOCK("precomputing");
+      // Nothing is built until all positions are chosen, so the counts stay valid for all makers.
+      PredicateIndex index(builder, area);
       for (int i : All(insideMakers)) {
-        pair<vector<Vec2>, LevelBuilder::Rot> res;
+        auto precomputed = predicate[i].precompute(index);
+        // Positions don't depend on the rotation, only on whether it swaps the sides.
+        optional<vector<Vec2>> positions[2];
+        LevelBuilder::Rot rotation;
+        bool swapped = false;
         for (auto iter : Range(100)) {
-          res = getAllowedPositions(builder, area, insideMakers[i].get(), predicate[i], sizes[i]);
-          if (!res.first.empty())
+          rotation = builder->getRandom().choose(
+              LevelBuilder::CW0, LevelBuilder::CW1, LevelBuilder::CW2, LevelBuilder::CW3);
+          swapped = contains({LevelBuilder::CW1, LevelBuilder::CW3}, rotation);
+          if (!positions[swapped])
+            positions[swapped] = getAllowedPositions(area, insideMakers[i].get(), precomputed,
+                swapped ? Vec2(sizes[i].y, sizes[i].x) : sizes[i]);
+          if (!positions[swapped]->empty())
             break;
         }
-        checkGen(optionalMakers.count(insideMakers[i].get()) || !res.first.empty());
-        allowedPositions.push_back(res.first);
-        rotations.push_back(res.second);
+        checkGen(optionalMakers.count(insideMakers[i].get()) || !positions[swapped]->empty(), "RandomLocations");
+        allowedPositions.push_back(std::move(*positions[swapped]));
+        rotations.push_back(rotation);
       }
     }
     {
@@ -1234,16 +1300,22 @@ class RandomLocations : public LevelMaker {
       for (int i : Range(300))
         if (tryMake(builder, allowedPositions, rotations))
           return;
-      failGen(); // "Failed to find free space for " << (int)sizes.size() << " areas";
+      failGen("RandomLocations"); // "Failed to find free space for " << (int)sizes.size() << " areas";
     }
   }
 
-  bool checkDistances(int makerIndex, Rectangle area, const vector<optional<Rectangle>>& occupied,
-      const vector<optional<double>>& minDist, const vector<optional<double>>& maxDist) {
-    for (int j : Range(makerIndex))
-      if (auto bounds = occupied[j]) {
+  struct DistanceLimit {
+    int makerIndex;
+    optional<double> minDist;
+    optional<double> maxDist;
+  };
+
+  bool checkDistances(Rectangle area, const vector<optional<Rectangle>>& occupied,
+      const vector<DistanceLimit>& limits) {
+    for (auto& limit : limits)
+      if (auto bounds = occupied[limit.makerIndex]) {
         auto distance = area.getDistance(*bounds);
-        if ((maxDist[j] && *maxDist[j] < distance) || (minDist[j] && *minDist[j] > distance))
+        if ((limit.maxDist && *limit.maxDist < distance) || (limit.minDist && *limit.minDist > distance))
           return false;
       }
     return true;
@@ -1256,7 +1328,7 @@ class RandomLocations : public LevelMaker {
     return true;
   }
 
-  bool tryMake(LevelBuilder* builder, const vector<vector<Vec2>>& allowedPositions,
+  bool tryMake(LevelBuilder* builder, vector<vector<Vec2>>& allowedPositions,
       const vector<LevelBuilder::Rot>& rotations) {
     PROFILE;
     vector<optional<Rectangle>> occupied;
@@ -1268,18 +1340,24 @@ class RandomLocations : public LevelMaker {
       auto size = sizes[makerIndex];
       if (contains({LevelBuilder::CW1, LevelBuilder::CW3}, rotations[makerIndex]))
         std::swap(size.x, size.y);
-      vector<optional<double>> maxDist(makerIndex);
-      vector<optional<double>> minDist(makerIndex);
+      vector<DistanceLimit> limits;
       for (int j : Range(makerIndex)) {
-        maxDist[j] = getValueMaybe(maxDistance, make_pair(insideMakers[j].get(), maker));
-        minDist[j] = getValueMaybe(minDistance, make_pair(insideMakers[j].get(), maker));
+        auto maxDist = getValueMaybe(maxDistance, make_pair(insideMakers[j].get(), maker));
+        auto minDist = getValueMaybe(minDistance, make_pair(insideMakers[j].get(), maker));
+        if (minDist || maxDist)
+          limits.push_back(DistanceLimit{j, minDist, maxDist});
       }
       auto findGoodPosition = [&] () -> optional<Vec2> {
-        for (auto& pos : builder->getRandom().permutation(allowedPositions[makerIndex])) {
+        // Shuffles only as far as needed, usually one of the first positions is good. This draws fewer random
+        // numbers than shuffling the whole list, so the same seed doesn't produce the same map as before.
+        auto& positions = allowedPositions[makerIndex];
+        for (int i : All(positions)) {
+          std::swap(positions[i], positions[builder->getRandom().get(i, positions.size())]);
+          auto pos = positions[i];
           Progress::checkIfInterrupted();
           Rectangle area(pos, pos + size);
           if ((canOverlap || checkIntersections(area, occupied)) &&
-              checkDistances(makerIndex, area, occupied, minDist, maxDist)) {
+              checkDistances(area, occupied, limits)) {
             return pos;
           }
         }
@@ -1533,7 +1611,7 @@ class Roads : public LevelMaker {
           Vec2::directions4(builder->getRandom()), p1, p2);
       for (Vec2 v = p2; v != p1; v = path.getNextMove(v)) {
         if (!path.isReachable(v))
-          failGen();
+          failGen("Roads");
         auto roadType = getRoadType(builder, v);
         if (v != p2 && v != p1 && !builder->isFurnitureType(v, roadType))
           builder->putFurniture(v, roadType);
@@ -1572,7 +1650,7 @@ class TransferPos : public LevelMaker {
         builder->modSquare(pos)->setLandingLink(stairKey);
         found = true;
       }
-    checkGen(found);
+    checkGen(found, "TransferPos");
   }
 
   private:
@@ -1677,7 +1755,7 @@ class Stairs : public LevelMaker {
       if (onPredicate.apply(builder, v) && builder->canPutFurniture(v,
           builder->getContentFactory()->furniture.getData(stairs).getLayer()))
         allPos.push_back(v);
-    checkGen(allPos.size() > 0);
+    checkGen(allPos.size() > 0, "Stairs");
     Vec2 pos = allPos[builder->getRandom().get(allPos.size())];
     builder->putFurniture(pos, FurnitureParams{stairs, TribeId::getHostile()});
     builder->setLandingLink(pos, key);
@@ -2776,7 +2854,7 @@ namespace {
         for (auto& elem : upStairs)
           USER_CHECK(!elem) << "Custom map " << id.data() << " doesn't contain required up stairs";
       } else
-        failGen();
+        failGen("RandomLayoutMaker");
     }
 
     private:
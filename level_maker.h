@@ -28,6 +28,10 @@ struct SettlementInfo;
 struct ResourceCounts;
 
 class LevelGenException {
+  public:
+  // The maker is the name of the LevelMaker that gave up, for statistics of failed generation attempts.
+  LevelGenException(const char* maker) : maker(maker) {}
+  const char* maker;
 };
 
 class FilePath;
@@ -58,6 +58,10 @@
 #include "unlocks.h"
 #include "steam_input.h"
 #include "steam_achievements.h"
+#include "sim_benchmark.h"
+#include "field_of_view.h"
+#include "game.h"
+#include "sectioned_file.h"
 
 #include "stack_printer.h"
 
@@ -135,9 +139,18 @@ static po::parser getCommandLineFlags() {
   flags["endless_enemy"].type(po::string).description("Endless mode enemy index");
   flags["battle_view"].description("Open game window and display battle");
   flags["battle_rounds"].type(po::i32).description("Number of battle rounds");
+  flags["benchmark"].type(po::string).description("Run headless simulation benchmark scenarios (comma separated list or \"all\")");
+  flags["benchmark_turns"].type(po::i32).description("Number of turns to simulate in each benchmark scenario");
+  flags["benchmark_seed"].type(po::i32).description("Random seed for the benchmark scenarios");
+  flags["benchmark_out"].type(po::string).description("Path to the JSON file with benchmark results");
   flags["layout_size"].type(po::string).description("Size of the generated map layout");
   flags["layout_name"].type(po::string).description("Name of layout to generate");
   flags["stderr"].description("Log to stderr");
+  flags["profile"].type(po::string).description("Record built-in profiler data and write it to files with the given path prefix");
+  flags["offscreen_threads"].type(po::i32).description("Experimental: simulate active sites other than the current one on this many worker threads (off by default)");
+  flags["save_threads"].type(po::i32).description("Compress and decompress save files on this many threads");
+  flags["level_gen_threads"].type(po::i32).description("Run this many level generation attempts at the same time");
+  flags["fov_cache_mb"].type(po::i32).description("Memory budget of the field of view cache per level in megabytes");
   flags["console"].description("Attach windows console");
   flags["nolog"].description("No logging");
   flags["no_crash_reports"].description("Don't intercept game crashes and send crash reports to the developer");
@@ -239,6 +252,19 @@ static void showLogoSplash(Renderer& renderer, FilePath logoPath, atomic<bool>&
 
 static int keeperMain(po::parser& commandLineFlags) {
   ENABLE_PROFILER;
+#ifndef BUILD_WITH_EASY_PROFILER
+  if (commandLineFlags["profile"].was_set())
+    Profiler::start(commandLineFlags["profile"].get().string);
+  DestructorFunction stopProfiler([] { Profiler::stop(); });
+#endif
+  if (commandLineFlags["offscreen_threads"].was_set())
+    Game::setOffscreenSimulationThreads(commandLineFlags["offscreen_threads"].get().i32);
+  if (commandLineFlags["fov_cache_mb"].was_set())
+    FieldOfView::setMemoryBudget((long long) commandLineFlags["fov_cache_mb"].get().i32 * 1024 * 1024);
+  if (commandLineFlags["save_threads"].was_set())
+    SectionedOutput::setCompressionThreads(commandLineFlags["save_threads"].get().i32);
+  if (commandLineFlags["level_gen_threads"].was_set())
+    ModelBuilder::setParallelAttempts(commandLineFlags["level_gen_threads"].get().i32);
   if (commandLineFlags["help"].was_set()) {
     std::cout << commandLineFlags << endl;
     return 0;
@@ -398,6 +424,32 @@ static int keeperMain(po::parser& commandLineFlags) {
       }
     } catch (GameExitException) {}
   };
+  if (commandLineFlags["benchmark"].was_set()) {
+    vector<BenchmarkScenario> scenarios;
+    auto names = commandLineFlags["benchmark"].get().string;
+    if (names == "all") {
+      for (auto scenario : ENUM_ALL(BenchmarkScenario))
+        scenarios.push_back(scenario);
+    } else
+      for (auto& name : split(names, {','}))
+        if (auto scenario = EnumInfo<BenchmarkScenario>::fromStringSafe(toUpper(name)))
+          scenarios.push_back(*scenario);
+        else {
+          std::cerr << "Unknown benchmark scenario: " << name << endl;
+          return -1;
+        }
+    auto numTurns = commandLineFlags["benchmark_turns"].was_set() ? commandLineFlags["benchmark_turns"].get().i32 : 500;
+    auto seed = commandLineFlags["benchmark_seed"].was_set() ? commandLineFlags["benchmark_seed"].get().i32 : 1234;
+    MainLoop loop(new DummyView(&clock), &highscores, &fileSharing, paidDataPath, freeDataPath, userPath, modsDir,
+        &options, nullptr, &sokobanInput, nullptr, &allUnlocked, nullptr, 0, "");
+    auto results = loop.runBenchmarks(scenarios, numTurns, seed);
+    if (commandLineFlags["benchmark_out"].was_set()) {
+      ofstream output(commandLineFlags["benchmark_out"].get().string);
+      writeBenchmarkJson(output, results);
+    } else
+      writeBenchmarkJson(std::cout, results);
+    return 0;
+  }
   if (commandLineFlags["battle_level"].was_set() && !commandLineFlags["battle_view"].was_set()) {
     battleTest(new DummyView(&clock), nullptr);
     return 0;
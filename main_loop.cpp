@@ -58,6 +58,8 @@
 #include "scripted_ui_data.h"
 #include "version.h"
 #include "collective.h"
+#include "sim_benchmark.h"
+#include "sokoban_input.h"
 
 #ifdef USE_STEAMWORKS
 #include "steam_ugc.h"
@@ -111,14 +113,13 @@ bool MainLoop::useSingleThread() {
 
 template <typename T>
 optional<T> MainLoop::loadFromFile(const FilePath& filename) {
+  // Saves from before the sectioned format have incompatible versions, see parse_game.h.
+  if (!SectionedInput::isSectioned(filename))
+    return none;
   auto f = [&] {
     T obj;
-    CompressedInput input(filename.getPath());
-    string discard;
-    SavedGameInfo discard2;
-    int version;
-    input.getArchive() >> version >> discard >> discard2;
-    input.getArchive() >> obj;
+    SectionedInput input(filename);
+    input.readSection(saveDataSection, obj);
     return std::move(obj);
   };
   if (useSingleThread())
@@ -130,12 +131,55 @@ optional<T> MainLoop::loadFromFile(const FilePath& filename) {
   }
 }
 
-void MainLoop::saveGame(PGame& game, const FilePath& path) {
-  CompressedOutput out(path.getPath());
+template <typename Output>
+static void addGameSections(Output& out, int saveVersion, PGame& game, vector<string> spriteMods) {
   string name = game->getGameDisplayName();
-  SavedGameInfo savedInfo = game->getSavedGameInfo(tileSet->getSpriteMods());
-  out.getArchive() << saveVersion << name << savedInfo;
-  out.getArchive() << game;
+  SavedGameInfo savedInfo = game->getSavedGameInfo(std::move(spriteMods));
+  out.addSection(saveHeaderSection, saveVersion, name);
+  out.addSection(saveInfoSection, savedInfo);
+  out.addSection(saveDataSection, game);
+}
+
+void MainLoop::saveGame(PGame& game, const FilePath& path) {
+  SectionedOutput out(path);
+  // There is no tile set in headless benchmarks.
+  addGameSections(out, saveVersion, game, tileSet ? tileSet->getSpriteMods() : vector<string>());
+}
+
+void MainLoop::autosave(PGame& game) {
+  if (!options->getBoolValue(OptionId::BACKGROUND_AUTOSAVE)) {
+    saveUI(game, GameSaveType::AUTOSAVE);
+    eraseAllSavesExcept(game, GameSaveType::AUTOSAVE);
+    return;
+  }
+  finishBackgroundSave();
+  auto path = getSavePath(game, GameSaveType::AUTOSAVE);
+  vector<FilePath> otherSaves;
+  for (auto type : ENUM_ALL(GameSaveType))
+    if (type != GameSaveType::WARLORD && type != GameSaveType::AUTOSAVE)
+      otherSaves.push_back(getSavePath(game, type));
+  // The game only stands still while it's serialized into memory. Compressing and writing the file happens on
+  // another thread, into a temporary file, so that the previous saves stay intact until the new one is complete.
+  auto buffer = make_shared<SectionedBuffer>();
+  MEASURE(addGameSections(*buffer, saveVersion, game, tileSet ? tileSet->getSpriteMods() : vector<string>()),
+      "autosave snapshot time");
+  backgroundSave = makeScopedThread([buffer, path, otherSaves] {
+    auto tmpPath = path.withSuffix(".tmp");
+    bool written = false;
+    MEASURE(written = buffer->write(tmpPath), "background autosave time");
+    // On failure the previous autosave and the other saves are kept.
+    if (!written || !tmpPath.renameTo(path)) {
+      INFO << "Background autosave to " << path << " failed";
+      tmpPath.erase();
+      return;
+    }
+    for (auto& save : otherSaves)
+      save.erase();
+  });
+}
+
+void MainLoop::finishBackgroundSave() {
+  backgroundSave = none;
 }
 
 struct RetiredModelInfo {
@@ -160,15 +204,16 @@ optional<RetiredModelInfo> MainLoop::loadRetiredModelFromFile(const FilePath& pa
 void MainLoop::saveMainModel(PGame& game, const FilePath& modelPath) {
   FilePath tmpPath = modelPath.withSuffix(".tmp");
   {
-    CompressedOutput modelOut(tmpPath.getPath());
+    SectionedOutput modelOut(tmpPath);
     string name = game->getGameDisplayName();
     SavedGameInfo savedInfo = game->getSavedGameInfo(tileSet->getSpriteMods());
-    modelOut.getArchive() << saveVersion << name << savedInfo;
+    modelOut.addSection(saveHeaderSection, saveVersion, name);
+    modelOut.addSection(saveInfoSection, savedInfo);
     RetiredModelInfoWithReference info {
       game->getMainModel().giveMeSharedPointer(),
       game->getContentFactory()
     };
-    modelOut.getArchive() << info;
+    modelOut.addSection(saveDataSection, info);
   }
   tmpPath.copyTo(modelPath);
   tmpPath.erase();
@@ -207,6 +252,7 @@ FilePath MainLoop::getSavePath(const PGame& game, GameSaveType gameType) {
 }
 
 void MainLoop::saveUI(PGame& game, GameSaveType type) {
+  finishBackgroundSave();
   auto path = getSavePath(game, type);
   function<void()> uploadFun = nullptr;
   if (type == GameSaveType::RETIRED_SITE) {
@@ -246,6 +292,7 @@ enum class MainLoop::ExitCondition {
 };
 
 void MainLoop::bugReportSave(PGame& game, FilePath path) {
+  finishBackgroundSave();
   int saveTime = game->getSaveProgressCount();
   doWithSplash("Saving game...", saveTime,
       [&] (ProgressMeter& meter) {
@@ -269,6 +316,7 @@ MainLoop::ExitCondition MainLoop::playGame(PGame game, bool withMusic, bool noAu
   registerModPlaytime(true);
   OnExit on_exit([&]() {
     registerModPlaytime(false);
+    finishBackgroundSave();
   });
   if (tileSet)
     tileSet->setTilePathsAndReload(game->getContentFactory()->tilePaths);
@@ -341,8 +389,7 @@ MainLoop::ExitCondition MainLoop::playGame(PGame game, bool withMusic, bool noAu
     }
     auto autoSaveFreq = options->getIntValue(OptionId::AUTOSAVE2);
     if (autoSaveFreq > 0 && lastAutoSave < gameTime - TimeInterval(autoSaveFreq) && !noAutoSave) {
-      saveUI(game, GameSaveType::AUTOSAVE);
-      eraseAllSavesExcept(game, GameSaveType::AUTOSAVE);
+      autosave(game);
       lastAutoSave = gameTime;
     }
     view->refreshView();
@@ -350,6 +397,7 @@ MainLoop::ExitCondition MainLoop::playGame(PGame game, bool withMusic, bool noAu
 }
 
 void MainLoop::eraseAllSavesExcept(const PGame& game, optional<GameSaveType> except) {
+  finishBackgroundSave();
   for (auto erasedType : ENUM_ALL(GameSaveType))
     if (erasedType != GameSaveType::WARLORD && erasedType != except)
       eraseSaveFile(game, erasedType);
@@ -914,7 +962,8 @@ ContentFactory MainLoop::createContentFactory(bool vanillaOnly) const {
   ContentFactory ret;
   auto tryConfig = [&](const vector<string>& modNames) {
     auto config = getGameConfig(modNames);
-    return ret.readData(&config, modNames);
+    auto cachePath = userPath.file("content_" + toString(combineHash(modNames)) + ".cache");
+    return ret.readDataCached(&config, modNames, cachePath);
   };
   if (vanillaOnly) {
 #ifdef RELEASE
@@ -966,17 +1015,130 @@ void MainLoop::launchQuickGame(optional<int> maxTurns, bool tryToLoad) {
     }
   }
   if (!game) {
-    AvatarInfo avatar = getQuickGameAvatar(view, contentFactory.keeperCreatures, &contentFactory.getCreatures());
-    CampaignBuilder builder(view, Random, options, contentFactory.villains, contentFactory.gameIntros, avatar);
-    auto result = builder.prepareCampaign(&contentFactory, bindMethod(&MainLoop::getRetiredGames, this),
-        CampaignType::QUICK_MAP, "Jarnsaxaland");
-    auto models = prepareCampaignModels(*result, std::move(avatar), Random, &contentFactory);
-    game = Game::campaignGame(std::move(models.models), *result, std::move(avatar), std::move(contentFactory), {});
+    game = prepareQuickGame(std::move(contentFactory));
     dumpMemUsage(game);
   }
   playGame(std::move(game), true, false, nullptr, milliseconds{3}, maxTurns);
 }
 
+PGame MainLoop::prepareQuickGame(ContentFactory contentFactory) {
+  AvatarInfo avatar = getQuickGameAvatar(view, contentFactory.keeperCreatures, &contentFactory.getCreatures());
+  CampaignBuilder builder(view, Random, options, contentFactory.villains, contentFactory.gameIntros, avatar);
+  auto result = builder.prepareCampaign(&contentFactory, bindMethod(&MainLoop::getRetiredGames, this),
+      CampaignType::QUICK_MAP, "Jarnsaxaland");
+  auto models = prepareCampaignModels(*result, std::move(avatar), Random, &contentFactory);
+  return Game::campaignGame(std::move(models.models), *result, std::move(avatar), std::move(contentFactory), {});
+}
+
+static void addBenchmarkMinions(Game* game, int count) {
+  auto collective = game->getPlayerCollective();
+  auto& factory = game->getContentFactory()->getCreatures();
+  auto leader = collective->getLeaders()[0]->getPosition();
+  for (int i : Range(count)) {
+    auto id = i % 5 == 0 ? CreatureId("IMP") : CreatureId("ORC");
+    auto traits = i % 5 == 0 ? EnumSet<MinionTrait>{MinionTrait::WORKER, MinionTrait::NO_LIMIT}
+        : EnumSet<MinionTrait>{MinionTrait::FIGHTER};
+    collective->addCreature(factory.fromId(id, collective->getTribeId(), MonsterAIFactory::collective(collective)),
+        leader, traits);
+  }
+}
+
+static Table<char> getSiegeArena() {
+  // Attackers start on the left, defenders on the right.
+  Table<char> ret(80, 40, '.');
+  auto bounds = ret.getBounds();
+  for (auto v : bounds)
+    if (v.x == 0 || v.y == 0 || v.x == bounds.right() - 1 || v.y == bounds.bottom() - 1)
+      ret[v] = '#';
+    else if (v.x < 12)
+      ret[v] = 'e';
+    else if (v.x >= bounds.right() - 12)
+      ret[v] = 'a';
+    else if (v.x % 9 == 0 && v.y % 6 < 3)
+      ret[v] = '#';
+  return ret;
+}
+
+PGame MainLoop::prepareBenchmarkGame(BenchmarkScenario scenario) {
+  auto contentFactory = createContentFactory(true);
+  switch (scenario) {
+    case BenchmarkScenario::SMALL_KEEPER:
+      return prepareQuickGame(std::move(contentFactory));
+    case BenchmarkScenario::LATE_GAME: {
+      auto game = prepareQuickGame(std::move(contentFactory));
+      addBenchmarkMinions(game.get(), 150);
+      return game;
+    }
+    case BenchmarkScenario::SIEGE: {
+      ProgressMeter meter(1);
+      EnemyFactory enemyFactory(Random, contentFactory.getCreatures().getNameGenerator(),
+          contentFactory.enemies, contentFactory.buildingInfo, {});
+      auto allies = CreatureList(120, CreatureId("ORC")).generate(Random, &contentFactory.getCreatures(),
+          TribeId::getDarkKeeper(), MonsterAIFactory::monster());
+      vector<CreatureList> enemies {CreatureList(80, CreatureId("KNIGHT")), CreatureList(40, CreatureId("ARCHER"))};
+      auto model = ModelBuilder(&meter, Random, options, sokobanInput, &contentFactory, std::move(enemyFactory))
+          .battleModel(getSiegeArena(), std::move(allies), std::move(enemies));
+      return Game::splashScreen(std::move(model), CampaignBuilder::getEmptyCampaign(), std::move(contentFactory), view);
+    }
+    case BenchmarkScenario::PATHFINDING:
+    case BenchmarkScenario::TIME_QUEUE:
+    case BenchmarkScenario::PARTICLES:
+      FATAL << "Micro-benchmarks don't run a game";
+  }
+}
+
+BenchmarkResult MainLoop::runBenchmark(BenchmarkScenario scenario, int numTurns, int seed) {
+  if (scenario == BenchmarkScenario::PATHFINDING)
+    return runPathfindingBenchmark(numTurns, seed);
+  if (scenario == BenchmarkScenario::TIME_QUEUE)
+    return runTimeQueueBenchmark(numTurns, seed);
+  if (scenario == BenchmarkScenario::PARTICLES)
+    return runParticleBenchmark(numTurns, seed);
+  Random.init(seed);
+  auto game = prepareBenchmarkGame(scenario);
+  Encyclopedia encyclopedia(game->getContentFactory());
+  game->initialize(options, highscores, view, fileSharing, &encyclopedia, unlocks, steamAchievements);
+  ProgressMeter meter(1);
+  game->initializeModels(meter);
+  int numCreatures = 0;
+  for (auto model : game->getAllModels())
+    numCreatures += model->getAllCreatures().size();
+  PhaseTimers::reset();
+  PhaseTimers::setEnabled(true);
+  const auto startTurn = game->getGlobalTime();
+  const auto startTime = steady_clock::now();
+  while (game->getGlobalTime() < startTurn + TimeInterval(numTurns))
+    if (game->update(1, Clock::getRealMillis() + milliseconds{1000000}))
+      break;
+  const auto totalTime = steady_clock::now() - startTime;
+  auto savePath = userPath.file("benchmark.tmp");
+  {
+    BENCHMARK_PHASE(SAVE);
+    saveGame(game, savePath);
+  }
+  savePath.erase();
+  PhaseTimers::setEnabled(false);
+  return BenchmarkResult{
+    scenario,
+    seed,
+    game->getGlobalTime().getVisibleInt() - startTurn.getVisibleInt(),
+    numCreatures,
+    totalTime,
+    EnumMap<BenchmarkPhase, steady_clock::duration>([](BenchmarkPhase p) { return PhaseTimers::getTotal(p); }),
+    EnumMap<BenchmarkPhase, long long>([](BenchmarkPhase p) { return PhaseTimers::getCount(p); }),
+    getPeakRssKb()
+  };
+}
+
+vector<BenchmarkResult> MainLoop::runBenchmarks(const vector<BenchmarkScenario>& scenarios, int numTurns, int seed) {
+  vector<BenchmarkResult> ret;
+  for (auto scenario : scenarios) {
+    std::cerr << "Running benchmark " << EnumInfo<BenchmarkScenario>::getString(scenario) << std::endl;
+    ret.push_back(runBenchmark(scenario, numTurns, seed));
+  }
+  return ret;
+}
+
 void MainLoop::start(bool tilesPresent) {
   tileSet->setTilePathsAndReload(getTilePathsForAllMods());
   view->playVideo(paidDataPath.file("intro.ogv").getPath());
@@ -1275,8 +1437,9 @@ ModelTable MainLoop::prepareCampaignModels(CampaignSetup& setup, const AvatarInf
   int numRetiredVillains = 0;
   doWithSplash("Generating map...", numSites,
       [&] (ProgressMeter& meter) {
+        vector<Vec2> toGenerate;
         for (Vec2 v : sites.getBounds()) {
-          if (!sites[v].isEmpty())
+          if (!sites[v].isEmpty() && !sites[v].getVillain())
             meter.addProgress();
           int difficulty = setup.campaign.getBaseLevelIncrease(v);
           if (auto info = sites[v].getKeeper()) {
@@ -1295,11 +1458,12 @@ ModelTable MainLoop::prepareCampaignModels(CampaignSetup& setup, const AvatarInf
                         break;
                       }
             }
-            if (!models[v])
-              models[v] = modelBuilder.campaignSiteModel(villain->enemyId, villain->type, avatarInfo.tribeAlignment,
-                  *setup.campaign.getSites()[v].biome, difficulty);
-            for (auto c : models[v]->getAllCreatures())
-              c->setCombatExperience(difficulty);
+            if (models[v]) {
+              for (auto c : models[v]->getAllCreatures())
+                c->setCombatExperience(difficulty);
+              meter.addProgress();
+            } else
+              toGenerate.push_back(v);
           } else if (auto retired = sites[v].getRetired()) {
             if (auto info = loadRetiredModelFromFile(userPath.file(retired->fileInfo.filename))) {
               models[v] = PModel(std::move(info->model));
@@ -1316,6 +1480,46 @@ ModelTable MainLoop::prepareCampaignModels(CampaignSetup& setup, const AvatarInf
             }
           }
         }
+        if (toGenerate.empty())
+          return;
+        // Every site draws from its own generator seeded from the campaign, and from its own share of the names,
+        // so the result doesn't depend on the number of threads or the order in which they finish.
+        // The same goes for the sokoban levels.
+        int campaignSeed = modelBuilder.getRandom().get(1000000000);
+        auto nameGenerator = contentFactory->getCreatures().getNameGenerator();
+        auto nameParts = nameGenerator->split(toGenerate.size());
+        vector<SokobanInput> sokobanParts;
+        for (int i : All(toGenerate))
+          sokobanParts.push_back(sokobanInput->forSite(i));
+        vector<std::exception_ptr> exceptions(toGenerate.size());
+        ThreadPool pool(min<int>(ThreadPool::getDefaultNumThreads(), toGenerate.size()));
+        for (int i : All(toGenerate))
+          pool.addTask([&, i] {
+            Vec2 v = toGenerate[i];
+            RandomGen random;
+            random.init(campaignSeed + v.x * 1009 + v.y);
+            ScopedRandomOverride randomOverride(random);
+            ScopedNameGeneratorOverride nameOverride(*nameGenerator, nameParts[i]);
+            auto villain = sites[v].getVillain();
+            int difficulty = setup.campaign.getBaseLevelIncrease(v);
+            try {
+              auto builder = modelBuilder.withRandom(random);
+              builder.setSokobanInput(&sokobanParts[i]);
+              models[v] = builder.campaignSiteModel(villain->enemyId, villain->type, avatarInfo.tribeAlignment,
+                  *sites[v].biome, difficulty);
+              for (auto c : models[v]->getAllCreatures())
+                c->setCombatExperience(difficulty);
+            } catch (...) {
+              exceptions[i] = std::current_exception();
+            }
+            meter.addProgress();
+          });
+        pool.wait();
+        for (auto& exception : exceptions)
+          if (exception)
+            std::rethrow_exception(exception);
+        sokobanInput->skip(toGenerate.size());
+        nameGenerator->join(nameParts);
       });
   if (failedToLoad)
     view->presentText("Sorry", "Error reading " + *failedToLoad + ". Leaving blank site.");
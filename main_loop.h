@@ -33,6 +33,8 @@ class TribeId;
 struct RetiredModelInfo;
 class Unlocks;
 class SteamAchievements;
+enum class BenchmarkScenario;
+struct BenchmarkResult;
 
 class MainLoop {
   public:
@@ -48,6 +50,7 @@ class MainLoop {
   void campaignBattleText(int numTries, const FilePath& levelPath, EnemyId keeperId, VillainGroup);
   int campaignBattleText(int numTries, const FilePath& levelPath, EnemyId keeperId, EnemyId);
   void launchQuickGame(optional<int> maxTurns, bool tryToLoad);
+  vector<BenchmarkResult> runBenchmarks(const vector<BenchmarkScenario>&, int numTurns, int seed);
   void genZLevels(const string& keeperType);
   ContentFactory createContentFactory(bool vanillaOnly) const;
 
@@ -103,8 +106,14 @@ class MainLoop {
   void considerFreeVersionText(bool tilesPresent);
   void eraseAllSavesExcept(const PGame&, optional<GameSaveType>);
   PGame prepareTutorial(const ContentFactory*);
+  PGame prepareQuickGame(ContentFactory);
+  PGame prepareBenchmarkGame(BenchmarkScenario);
+  BenchmarkResult runBenchmark(BenchmarkScenario, int numTurns, int seed);
   void bugReportSave(PGame&, FilePath);
   void saveGame(PGame&, const FilePath&);
+  void autosave(PGame&);
+  // Waits for the autosave that is being written in the background.
+  void finishBackgroundSave();
   void saveMainModel(PGame&, const FilePath& modelPath);
   TilePaths getTilePathsForAllMods() const;
   vector<string> getCurrentMods() const;
@@ -131,4 +140,5 @@ class MainLoop {
   bool useSingleThread();
   Unlocks* unlocks;
   SteamAchievements* steamAchievements = nullptr;
+  optional<scoped_thread> backgroundSave;
 };
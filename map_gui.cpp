@@ -49,7 +49,7 @@ MapGui::MapGui(Callbacks call, SyncQueue<UserInput>& inputQueue, Clock* c, Optio
     unique_ptr<fx::FXRenderer> fxRenderer, unique_ptr<FXViewManager> fxViewManager)
     : objects(Level::getMaxBounds()), callbacks(call), inputQueue(inputQueue),
     clock(c), options(o), fogOfWar(Level::getMaxBounds(), false), extraBorderPos(Level::getMaxBounds(), {}),
-    lastSquareUpdate(Level::getMaxBounds()), connectionMap(Level::getMaxBounds()), guiFactory(f),
+    connectionMap(Level::getMaxBounds()), guiFactory(f),
     fxRenderer(std::move(fxRenderer)), fxViewManager(std::move(fxViewManager)) {
   clearCenter();
 }
@@ -1430,15 +1430,13 @@ bool MapGui::onClick(MouseButtonId b, Vec2 v) {
   }
 }
 
-void MapGui::updateObject(Vec2 pos, CreatureView* view, Renderer& renderer, milliseconds currentTime) {
+void MapGui::updateObject(Vec2 pos, CreatureView* view, Renderer& renderer) {
   auto level = view->getCreatureViewLevel();
   objects[pos].emplace();
   auto& index = *objects[pos];
   view->getViewIndex(pos, index);
   level->setNeedsRenderUpdate(pos, false);
-  if (index.hasObject(ViewLayer::FLOOR) || index.hasObject(ViewLayer::FLOOR_BACKGROUND))
-    index.setNightAmount(1.0 - level->getLight(pos));
-  lastSquareUpdate[pos] = currentTime;
+  updateNightAmount(pos, level);
   connectionMap[pos].clear();
   shadowed.erase(pos + Vec2(0, 1));
   if (index.hasObject(ViewLayer::FLOOR)) {
@@ -1460,6 +1458,12 @@ void MapGui::updateObject(Vec2 pos, CreatureView* view, Renderer& renderer, mill
   }
 }
 
+void MapGui::updateNightAmount(Vec2 pos, const Level* level) {
+  auto& index = *objects[pos];
+  if (index.hasObject(ViewLayer::FLOOR) || index.hasObject(ViewLayer::FLOOR_BACKGROUND))
+    index.setNightAmount(1.0 - level->getLight(pos));
+}
+
 double MapGui::getDistanceToEdgeRatio(Vec2 pos) {
   Vec2 v = projectOnScreen(pos);
   double ret = 100000;
@@ -1548,11 +1552,38 @@ void MapGui::updateObjects(CreatureView* view, Renderer& renderer, MapLayout* ma
       inst->clearUnorderedEffects();
     for (Vec2 pos : level->getBounds())
       level->setNeedsRenderUpdate(pos, true);
-  } else
-    for (Vec2 pos : mapLayout->getAllTiles(getBounds(), Level::getMaxBounds(), getScreenPos()))
-      if (level->needsRenderUpdate(pos) ||
-          !lastSquareUpdate[pos] || *lastSquareUpdate[pos] < currentTimeReal - milliseconds{1000})
-        updateObject(pos, view, renderer, currentTimeReal);
+    lastNightAmountUpdate = none;
+  } else {
+    auto visibleTiles = mapLayout->getAllTiles(getBounds(), Level::getMaxBounds(), getScreenPos());
+    const int chunkSize = Level::renderChunkSize;
+    vector<Vec2> visibleChunks;
+    for (int x = visibleTiles.left() - visibleTiles.left() % chunkSize; x < visibleTiles.right(); x += chunkSize)
+      for (int y = visibleTiles.top() - visibleTiles.top() % chunkSize; y < visibleTiles.bottom(); y += chunkSize)
+        visibleChunks.push_back(Vec2(x, y));
+    for (Vec2 chunk : visibleChunks)
+      if (level->chunkNeedsRenderUpdate(chunk))
+        for (Vec2 pos : Rectangle(chunk, chunk + Vec2(chunkSize, chunkSize)).intersection(visibleTiles))
+          if (level->needsRenderUpdate(pos))
+            updateObject(pos, view, renderer);
+    // Some highlights follow the state of the collective, like the population limit, prisons that aren't closed
+    // off or constructions delayed by danger, and nothing marks their tiles when it changes. To pick them up,
+    // one visible chunk is rebuilt every 250ms, round robin.
+    if (!visibleChunks.empty() && (!nextFallbackRefresh || *nextFallbackRefresh <= currentTimeReal)) {
+      Vec2 chunk = visibleChunks[fallbackRefreshChunk++ % visibleChunks.size()];
+      for (Vec2 pos : Rectangle(chunk, chunk + Vec2(chunkSize, chunkSize)).intersection(visibleTiles))
+        updateObject(pos, view, renderer);
+      nextFallbackRefresh = currentTimeReal + milliseconds{250};
+    }
+    // Sunlight changes with the time of day without marking the tiles, and tiles that scroll into view may have
+    // been lit while they were off screen.
+    auto nightAmountUpdate = make_pair(level->getGame()->getSunlightInfo().getLightAmount(), visibleTiles);
+    if (!lastNightAmountUpdate || *lastNightAmountUpdate != nightAmountUpdate) {
+      for (Vec2 pos : visibleTiles)
+        if (objects[pos])
+          updateNightAmount(pos, level);
+      lastNightAmountUpdate = nightAmountUpdate;
+    }
+  }
   previousView = view->getCenterType();
   auto isGroundOrUpperZlevel = [](auto l) { return l->above || l->below; };
   previousLevel = level;
@@ -100,7 +100,7 @@ class MapGui : public GuiElem {
   bool onRightClick(Vec2);
   bool onMiddleClick(Vec2);
   void onMouseRelease(Vec2);
-  void updateObject(Vec2, CreatureView*, Renderer&, milliseconds currentTime);
+  void updateObject(Vec2, CreatureView*, Renderer&);
   void drawObjectAbs(Renderer&, Vec2 pos, const ViewObject&, Vec2 size, Vec2 movement, Vec2 tilePos,
       milliseconds currentTimeReal, const ViewIndex&);
   void drawCreatureHighlights(Renderer&, const ViewObject&, const ViewIndex&, Vec2 pos, Vec2 sz,
@@ -165,7 +165,12 @@ class MapGui : public GuiElem {
   } mouseOffset, center;
   const Level* previousLevel = nullptr;
   optional<CreatureViewCenterType> previousView;
-  Table<optional<milliseconds>> lastSquareUpdate;
+  // Sunlight amount and visible tiles for which the night amount of the objects was last computed.
+  optional<pair<double, Rectangle>> lastNightAmountUpdate;
+  void updateNightAmount(Vec2, const Level*);
+  // Visible chunk that is refreshed next by the fallback refresh, and when.
+  int fallbackRefreshChunk = 0;
+  optional<milliseconds> nextFallbackRefresh;
   optional<Coords> softCenter;
   Vec2 lastMousePos;
   optional<Vec2> lastMouseMove;
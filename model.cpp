@@ -60,6 +60,7 @@
 #include "warlord_controller.h"
 #include "territory.h"
 #include "portals.h"
+#include "sim_benchmark.h"
 
 template <class Archive>
 void Model::serialize(Archive& ar, const unsigned int version) {
@@ -142,6 +143,7 @@ bool Model::update(double totalTime) {
 }
 
 void Model::tick(LocalTime time) { PROFILE
+  BENCHMARK_PHASE(MODEL_TICK);
   for (Creature* c : timeQueue->getAllCreatures()) {
     c->tick();
   }
@@ -41,6 +41,8 @@
 #include "zlevel.h"
 #include "avatar_info.h"
 #include "keeper_base_info.h"
+#include "creature_factory.h"
+#include "name_generator.h"
 
 using namespace std::chrono;
 
@@ -52,6 +54,18 @@ ModelBuilder::ModelBuilder(ProgressMeter* m, RandomGen& r, Options* o,
 ModelBuilder::~ModelBuilder() {
 }
 
+ModelBuilder ModelBuilder::withRandom(RandomGen& r) const {
+  return ModelBuilder(meter, r, nullptr, sokobanInput, contentFactory, enemyFactory->withRandom(r));
+}
+
+void ModelBuilder::setSokobanInput(SokobanInput* input) {
+  sokobanInput = input;
+}
+
+RandomGen& ModelBuilder::getRandom() {
+  return random;
+}
+
 ModelBuilder::LevelMakerMethod ModelBuilder::getMaker(LevelType type) {
   switch (type) {
     case LevelType::BASIC:
@@ -131,15 +145,68 @@ PModel ModelBuilder::tryCampaignSiteModel(EnemyId enemyId, VillainType type, Tri
   return tryModel(type == VillainType::MINOR ? 60 : 114, difficulty, enemyInfo, none, none, biomeId, {});
 }
 
-PModel ModelBuilder::tryBuilding(int numTries, function<PModel()> buildFun, const string& name) {
-  for (int i : Range(numTries)) {
+static int numParallelAttempts = 1;
+
+void ModelBuilder::setParallelAttempts(int num) {
+  numParallelAttempts = max(1, num);
+}
+
+namespace {
+struct BuildAttempt {
+  PModel model;
+  vector<NameGenerator> names;
+  const char* failedMaker = nullptr;
+  std::exception_ptr exception;
+};
+}
+
+PModel ModelBuilder::tryBuilding(int numTries, function<PModel(ModelBuilder&)> buildFun, const string& name) {
+  // Every attempt draws from its own generator and from its own copy of the names, and the lowest successful
+  // attempt wins, so the result doesn't depend on how many attempts run at the same time. Content ids are interned
+  // under a lock, see content_id.cpp. Exceptions other than LevelGenException are rethrown on this thread.
+  int seed = random.get(1000000000);
+  auto& sharedNames = *contentFactory->getCreatures().getNameGenerator();
+  auto& names = sharedNames.getForCurrentThread();
+  auto runAttempt = [&](int index, BuildAttempt& attempt, bool reportProgress) {
+    RandomGen attemptRandom;
+    attemptRandom.init(seed + index);
+    ScopedRandomOverride randomOverride(attemptRandom);
+    auto attemptNames = names.split(1);
+    ScopedNameGeneratorOverride nameOverride(sharedNames, attemptNames[0]);
+    auto builder = withRandom(attemptRandom);
+    if (!reportProgress)
+      builder.meter = nullptr;
     try {
-      if (meter)
-        meter->reset();
-      return buildFun();
-    } catch (LevelGenException) {
-      INFO << "Retrying level gen";
+      attempt.model = buildFun(builder);
+      attempt.names = std::move(attemptNames);
+    } catch (LevelGenException e) {
+      attempt.failedMaker = e.maker;
+    } catch (...) {
+      attempt.exception = std::current_exception();
     }
+  };
+  int waveSize = min(numParallelAttempts, numTries);
+  unique_ptr<ThreadPool> pool;
+  if (waveSize > 1)
+    pool = make_unique<ThreadPool>(waveSize);
+  for (int first = 0; first < numTries; first += waveSize) {
+    if (meter)
+      meter->reset();
+    vector<BuildAttempt> attempts(min(waveSize, numTries - first));
+    if (pool) {
+      for (int i : All(attempts))
+        pool->addTask([&, i] { runAttempt(first + i, attempts[i], i == 0); });
+      pool->wait();
+    } else
+      runAttempt(first, attempts[0], true);
+    for (auto& attempt : attempts)
+      if (attempt.exception)
+        std::rethrow_exception(attempt.exception);
+      else if (attempt.model) {
+        names.join(attempt.names);
+        return std::move(attempt.model);
+      } else
+        INFO << "Retrying level gen, " << attempt.failedMaker << " failed";
   }
   USER_FATAL << "Couldn't generate a level: " << name;
   return nullptr;
@@ -147,18 +214,19 @@ PModel ModelBuilder::tryBuilding(int numTries, function<PModel()> buildFun, cons
 
 PModel ModelBuilder::campaignBaseModel(const AvatarInfo& avatarInfo, BiomeId biome,
     optional<ExternalEnemiesType> externalEnemies) {
-  return tryBuilding(20, [&] { return tryCampaignBaseModel(avatarInfo.tribeAlignment,
-      avatarInfo.creatureInfo.startingBase, biome, externalEnemies); },
+  return tryBuilding(20, [&](ModelBuilder& builder) { return builder.tryCampaignBaseModel(
+      avatarInfo.tribeAlignment, avatarInfo.creatureInfo.startingBase, biome, externalEnemies); },
       "campaign base");
 }
 
 PModel ModelBuilder::tutorialModel(optional<KeeperBaseInfo> keeperBase) {
-  return tryBuilding(20, [=] { return tryTutorialModel(keeperBase); }, "tutorial");
+  return tryBuilding(20, [=](ModelBuilder& builder) { return builder.tryTutorialModel(keeperBase); }, "tutorial");
 }
 
 PModel ModelBuilder::campaignSiteModel(EnemyId enemyId, VillainType type, TribeAlignment alignment, BiomeId biome,
     int difficulty) {
-  return tryBuilding(20, [&] { return tryCampaignSiteModel(enemyId, type, alignment, biome, difficulty); },
+  return tryBuilding(20, [&](ModelBuilder& builder) {
+      return builder.tryCampaignSiteModel(enemyId, type, alignment, biome, difficulty); },
       enemyId.data());
 }
 
@@ -210,6 +278,7 @@ void ModelBuilder::measureSiteGen(int numTries, vector<string> types, vector<Bio
 
 void ModelBuilder::measureModelGen(const string& name, int numTries, function<void()> genFun) {
   int numSuccess = 0;
+  map<string, int> failedMakers;
   int maxT = 0;
   int minT = 1000000;
   double sumT = 0;
@@ -223,7 +292,8 @@ void ModelBuilder::measureModelGen(const string& name, int numTries, function<vo
       ++numSuccess;
       //std::cout << ".";
       //std::cout.flush();
-    } catch (LevelGenException) {
+    } catch (LevelGenException e) {
+      ++failedMakers[e.maker];
       //std::cout << "x";
       //std::cout.flush();
     }
@@ -236,6 +306,8 @@ void ModelBuilder::measureModelGen(const string& name, int numTries, function<vo
   }
   USER_INFO << numSuccess << " / " << numTries << ". MinT: " <<
     minT << ". MaxT: " << maxT << ". AvgT: " << sumT / numTries;
+  for (auto& elem : failedMakers)
+    USER_INFO << "  " << elem.first << " failed " << elem.second << " times";
 }
 
 void ModelBuilder::makeExtraLevel(Model* model, LevelConnection& connection, SettlementInfo& mainSettlement,
@@ -337,9 +409,12 @@ PModel ModelBuilder::tryModel(int width, int difficulty, vector<EnemyInfo> enemy
 }
 
 PModel ModelBuilder::battleModel(const FilePath& levelPath, vector<PCreature> allies, vector<CreatureList> enemies) {
-  auto m = Model::create(contentFactory, none, BiomeId("GRASSLAND"));
   ifstream stream(levelPath.getPath());
-  Table<char> level = *SokobanInput::readTable(stream);
+  return battleModel(*SokobanInput::readTable(stream), std::move(allies), std::move(enemies));
+}
+
+PModel ModelBuilder::battleModel(Table<char> level, vector<PCreature> allies, vector<CreatureList> enemies) {
+  auto m = Model::create(contentFactory, none, BiomeId("GRASSLAND"));
   Level* l = m->buildMainLevel(
       contentFactory,
       LevelBuilder(meter, Random, contentFactory, level.getBounds().width(), level.getBounds().height(), true, 1.0),
@@ -30,13 +30,22 @@ class ModelBuilder {
   ModelBuilder(ProgressMeter*, RandomGen&, Options*, SokobanInput*, ContentFactory*, EnemyFactory);
   ModelBuilder(ModelBuilder&&) = default;
   ModelBuilder(const ModelBuilder&) = delete;
+  // Builder with the same content that draws from a different generator, for generating sites on several threads.
+  ModelBuilder withRandom(RandomGen&) const;
+  void setSokobanInput(SokobanInput*);
+  RandomGen& getRandom();
   PModel campaignBaseModel(const AvatarInfo&, BiomeId, optional<ExternalEnemiesType>);
   PModel campaignSiteModel(EnemyId, VillainType, TribeAlignment, BiomeId, int difficulty);
   PModel tutorialModel(optional<KeeperBaseInfo>);
 
+  // Failed level generation attempts are retried. With more than one, this many attempts run at the same time.
+  // Default is 1.
+  static void setParallelAttempts(int);
+
   void measureSiteGen(int numTries, vector<string> types, vector<BiomeId> biomes);
 
   PModel battleModel(const FilePath& levelPath, vector<PCreature> allies, vector<CreatureList> enemies);
+  PModel battleModel(Table<char> level, vector<PCreature> allies, vector<CreatureList> enemies);
 
   ~ModelBuilder();
 
@@ -49,7 +58,7 @@ class ModelBuilder {
       optional<KeeperBaseInfo>, BiomeId, optional<ExternalEnemies>);
   void makeExtraLevel(Model* model, LevelConnection& connection, SettlementInfo& mainSettlement, StairKey upLink,
       vector<EnemyInfo>& extraEnemies, int depth, bool mainDungeon, int difficulty);
-  PModel tryBuilding(int numTries, function<PModel()> buildFun, const string& name);
+  PModel tryBuilding(int numTries, function<PModel(ModelBuilder&)> buildFun, const string& name);
   void addMapVillains(vector<EnemyInfo>&, const vector<BiomeEnemyInfo>&);
   RandomGen& random;
   ProgressMeter* meter = nullptr;
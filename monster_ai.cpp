@@ -56,6 +56,7 @@
 #include "automaton_part.h"
 #include "ai_type.h"
 #include "construction_map.h"
+#include "sim_benchmark.h"
 
 class Behaviour {
   public:
@@ -1208,6 +1209,7 @@ MonsterAI::MonsterAI(Creature* c, const vector<Behaviour*>& beh, const vector<in
 
 void MonsterAI::makeMove() {
   PROFILE;
+  BENCHMARK_PHASE(MONSTER_AI);
   vector<MoveInfo> moves;
   for (int i : All(behaviours)) {
     MoveInfo move = behaviours[i]->getMove();
@@ -70,11 +70,19 @@ NameGenerator::NameGenerator() {
 }
 
 
+NameGenerator::NameGenerator(map<NameGeneratorId, deque<string>> names) : names(std::move(names)) {
+}
+
 void NameGenerator::setNames(NameGeneratorId id, vector<string> v) {
   for (auto& name : Random.permutation(v))
     names[id].push_back(name);
 }
 
+void NameGenerator::shuffle() {
+  for (auto& elem : names)
+    Random.shuffle(elem.second.begin(), elem.second.end());
+}
+
 void NameGenerator::merge(NameGenerator g) {
   for (auto& elem : g.names)
     if (!names.count(elem.first))
@@ -82,13 +90,87 @@ void NameGenerator::merge(NameGenerator g) {
 }
 
 string NameGenerator::getNext(NameGeneratorId id) {
+  if (threadOverride.first == this)
+    return threadOverride.second->getNext(id);
   CHECK(!names[id].empty());
   string ret = names[id].front();
   names[id].pop_front();
   names[id].push_back(ret);
+  ++numTaken[id];
+  return ret;
+}
+
+NameGenerator& NameGenerator::getForCurrentThread() {
+  if (threadOverride.first == this)
+    return *threadOverride.second;
+  return *this;
+}
+
+vector<NameGenerator> NameGenerator::split(int numParts) const {
+  CHECK(numParts > 0);
+  vector<map<NameGeneratorId, deque<string>>> parts(numParts);
+  for (auto& elem : names) {
+    auto& list = elem.second;
+    for (int i : Range(numParts)) {
+      auto& part = parts[i][elem.first];
+      for (int j = i; j < list.size(); j += numParts)
+        part.push_back(list[j]);
+      // Fewer names than parts, so some of them have to repeat.
+      if (part.empty())
+        for (int j : Range(list.size()))
+          part.push_back(list[(i + j) % list.size()]);
+    }
+  }
+  vector<NameGenerator> ret;
+  for (auto& part : parts)
+    ret.push_back(NameGenerator(std::move(part)));
   return ret;
 }
 
+void NameGenerator::join(const vector<NameGenerator>& parts) {
+  int numParts = parts.size();
+  for (auto& elem : names) {
+    auto& list = elem.second;
+    int size = list.size();
+    vector<char> taken(size, 0);
+    int total = 0;
+    for (int i : Range(numParts))
+      if (auto num = getValueMaybe(parts[i].numTaken, elem.first)) {
+        total += *num;
+        // Mark the names that part i handed out, using the same layout as split().
+        if (i < size)
+          for (int k = 0, j = i; k < *num && j < size; ++k, j += numParts)
+            taken[j] = 1;
+        else
+          for (int k : Range(min(*num, size)))
+            taken[(i + k) % size] = 1;
+      }
+    if (total == 0)
+      continue;
+    // Like getNext(), the names that were handed out go to the back.
+    deque<string> reordered;
+    for (int j : Range(size))
+      if (!taken[j])
+        reordered.push_back(std::move(list[j]));
+    for (int j : Range(size))
+      if (taken[j])
+        reordered.push_back(std::move(list[j]));
+    list = std::move(reordered);
+    numTaken[elem.first] += total;
+  }
+}
+
+thread_local pair<NameGenerator*, NameGenerator*> NameGenerator::threadOverride { nullptr, nullptr };
+
+ScopedNameGeneratorOverride::ScopedNameGeneratorOverride(NameGenerator& shared, NameGenerator& part)
+    : previous(NameGenerator::threadOverride) {
+  NameGenerator::threadOverride = {&shared, &part};
+}
+
+ScopedNameGeneratorOverride::~ScopedNameGeneratorOverride() {
+  NameGenerator::threadOverride = previous;
+}
+
 vector<string> NameGenerator::getAll(NameGeneratorId id) {
   return vector<string>(names[id].begin(), names[id].end());
 }
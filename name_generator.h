@@ -29,9 +29,36 @@ class NameGenerator {
   NameGenerator(const NameGenerator&) = delete;
   NameGenerator(NameGenerator&&) = default;
 
+  // Splits the names between generators that can be drawn from on separate threads. Part i gets every
+  // numParts-th name starting with the i-th, so the parts don't repeat each other's names.
+  vector<NameGenerator> split(int numParts) const;
+  // Moves the names that were taken from the parts to the back, as if they were taken from this generator.
+  void join(const vector<NameGenerator>& parts);
+  // The generator that getNext() on this one draws from on the current thread. It's a different one inside
+  // a ScopedNameGeneratorOverride.
+  NameGenerator& getForCurrentThread();
+  // Puts the names in a new random order. Used when the generator was loaded instead of filled with setNames().
+  void shuffle();
+
   template <typename Archive>
   void serialize(Archive&, unsigned);
 
   private:
+  friend class ScopedNameGeneratorOverride;
+  NameGenerator(map<NameGeneratorId, deque<string>>);
   map<NameGeneratorId, deque<string>> SERIAL(names);
+  map<NameGeneratorId, int> numTaken;
+  static thread_local pair<NameGenerator*, NameGenerator*> threadOverride;
+};
+
+// While alive, getNext() called on the first generator on the current thread draws from the second one instead.
+// Code that only knows the shared generator from the content can then run on a worker thread.
+class ScopedNameGeneratorOverride {
+  public:
+  ScopedNameGeneratorOverride(NameGenerator& shared, NameGenerator& part);
+  ~ScopedNameGeneratorOverride();
+  ScopedNameGeneratorOverride(const ScopedNameGeneratorOverride&) = delete;
+
+  private:
+  pair<NameGenerator*, NameGenerator*> previous;
 };
@@ -199,6 +199,11 @@ namespace SDL {
   GLenum(EXT_ENTRY *glCheckFramebufferStatus)(GLenum target);
 
   void(EXT_ENTRY* glBlendFuncSeparate)(GLenum, GLenum, GLenum, GLenum);
+  void(EXT_ENTRY *glGenBuffers)(GLsizei n, GLuint *buffers);
+  void(EXT_ENTRY *glDeleteBuffers)(GLsizei n, const GLuint *buffers);
+  void(EXT_ENTRY *glBindBuffer)(GLenum target, GLuint buffer);
+  void(EXT_ENTRY *glBufferData)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+  void(EXT_ENTRY *glBufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 
   void(EXT_ENTRY *glDebugMessageCallback)(GLDEBUGPROC callback, const void *userParam);
   void(EXT_ENTRY *glDebugMessageControl)(GLenum source, GLenum type, GLenum severity,
@@ -223,6 +228,9 @@ bool isOpenglFeatureAvailable(OpenglFeature feature) {
   case OpenglFeature::DEBUG: // GL 4.4
     return ON_WINDOWS(SDL::glDebugMessageCallback && SDL::glDebugMessageControl &&)
         isOpenglExtensionAvailable("KHR_debug");
+  case OpenglFeature::VERTEX_BUFFER: // GL 1.5
+    return ON_WINDOWS(SDL::glGenBuffers && SDL::glDeleteBuffers && SDL::glBindBuffer && SDL::glBufferData &&
+                      SDL::glBufferSubData &&) true;
   }
 #undef ON_WINDOWS
 }
@@ -237,6 +245,11 @@ void initializeGLExtensions() {
   LOAD(glFramebufferTexture2D);
   LOAD(glDrawBuffers);
   LOAD(glBlendFuncSeparate);
+  LOAD(glGenBuffers);
+  LOAD(glDeleteBuffers);
+  LOAD(glBindBuffer);
+  LOAD(glBufferData);
+  LOAD(glBufferSubData);
 #undef LOAD
 #endif
 }
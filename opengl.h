@@ -21,7 +21,7 @@ void glColor(const Color&);
 void glQuad(float x, float y, float ex, float ey);
 void initializeGLExtensions();
 
-enum class OpenglFeature { FRAMEBUFFER, SEPARATE_BLEND_FUNC, DEBUG };
+enum class OpenglFeature { FRAMEBUFFER, SEPARATE_BLEND_FUNC, DEBUG, VERTEX_BUFFER };
 bool isOpenglFeatureAvailable(OpenglFeature);
 
 #ifdef WINDOWS
@@ -38,6 +38,11 @@ EXT_API void(EXT_ENTRY *glFramebufferTexture2D)(GLenum target, GLenum attachment
     GLuint texture, GLint level);
 EXT_API void(EXT_ENTRY *glDrawBuffers)(GLsizei n, const GLenum *bufs);
 EXT_API void(EXT_ENTRY *glBlendFuncSeparate)(GLenum, GLenum, GLenum, GLenum);
+EXT_API void(EXT_ENTRY *glGenBuffers)(GLsizei n, GLuint *buffers);
+EXT_API void(EXT_ENTRY *glDeleteBuffers)(GLsizei n, const GLuint *buffers);
+EXT_API void(EXT_ENTRY *glBindBuffer)(GLenum target, GLuint buffer);
+EXT_API void(EXT_ENTRY *glBufferData)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+EXT_API void(EXT_ENTRY *glBufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 EXT_API GLenum(EXT_ENTRY *glCheckFramebufferStatus)(GLenum target);
 EXT_API void(EXT_ENTRY *glDebugMessageCallback)(GLDEBUGPROC callback, const void *userParam);
 EXT_API void(EXT_ENTRY *glDebugMessageControl)(GLenum source, GLenum type, GLenum severity,
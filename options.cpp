@@ -56,6 +56,7 @@ const EnumMap<OptionId, Options::Value> defaults {
   {OptionId::KEEPER_WARNING, 1},
   {OptionId::KEEPER_WARNING_TIMEOUT, 200},
   {OptionId::SINGLE_THREAD, 0},
+  {OptionId::BACKGROUND_AUTOSAVE, 1},
   {OptionId::UNLOCK_ALL, 0},
   {OptionId::EXP_INCREASE, 1},
   {OptionId::DPI_AWARE, 0}
@@ -96,6 +97,7 @@ const map<OptionId, string> names {
   {OptionId::KEEPER_WARNING, "Keeper danger warning"},
   {OptionId::KEEPER_WARNING_TIMEOUT, "Keeper danger timeout"},
   {OptionId::SINGLE_THREAD, "Use a single thread for loading operations"},
+  {OptionId::BACKGROUND_AUTOSAVE, "Autosave in the background"},
   {OptionId::UNLOCK_ALL, "Unlock all hidden gameplay features"},
   {OptionId::EXP_INCREASE, "Enemy difficulty curve"},
   {OptionId::DPI_AWARE, "Override Windows DPI scaling"},
@@ -120,6 +122,8 @@ const map<OptionId, string> hints {
   {OptionId::KEEPER_WARNING_TIMEOUT, "Number of turns before a new \"Keeper in danger\" warning is shown"},
   {OptionId::SINGLE_THREAD, "Please try this option if you're experiencing slow saving, loading, or map generation. "
         "Note: this will make the game unresponsive during the operation."},
+  {OptionId::BACKGROUND_AUTOSAVE, "Only pause the game while it is copied to memory, and compress and write the "
+        "autosave while you keep playing. Turn off if the game runs low on memory."},
   {OptionId::UNLOCK_ALL, "Unlocks all player characters and gameplay features that are normally unlocked by finding secrets in the game."},
   {OptionId::EXP_INCREASE, "Defines the increase in experience for every lesser and main villain as you travel further away from your home site."},
   {OptionId::DPI_AWARE, "If you find the game blurry, this setting might help. Requires restarting the game. "},
@@ -142,6 +146,7 @@ const map<OptionSet, vector<OptionId>> optionSets {
       OptionId::ONLINE,
       OptionId::GAME_EVENTS,
       OptionId::AUTOSAVE2,
+      OptionId::BACKGROUND_AUTOSAVE,
       OptionId::KEEPER_WARNING,
       OptionId::KEEPER_WARNING_TIMEOUT,
       OptionId::SINGLE_THREAD,
@@ -322,6 +327,7 @@ static bool isBoolean(OptionId id) {
     case OptionId::DISABLE_CURSOR:
     case OptionId::START_WITH_NIGHT:
     case OptionId::SINGLE_THREAD:
+    case OptionId::BACKGROUND_AUTOSAVE:
     case OptionId::UNLOCK_ALL:
     case OptionId::DPI_AWARE:
       return true;
@@ -353,6 +359,7 @@ string Options::getValueString(OptionId id) {
     case OptionId::DISABLE_CURSOR:
     case OptionId::START_WITH_NIGHT:
     case OptionId::SINGLE_THREAD:
+    case OptionId::BACKGROUND_AUTOSAVE:
     case OptionId::UNLOCK_ALL:
       return getYesNo(value);
     case OptionId::SETTLEMENT_NAME:
@@ -57,6 +57,7 @@ RICH_ENUM(OptionId,
   ENDLESS_ENEMIES,
   ENEMY_AGGRESSION,
   SINGLE_THREAD,
+  BACKGROUND_AUTOSAVE,
   UNLOCK_ALL,
 
   EXP_INCREASE,
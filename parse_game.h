@@ -4,6 +4,7 @@
 #include "saved_game_info.h"
 #include "gzstream.h"
 #include "file_path.h"
+#include "sectioned_file.h"
 
 typedef StreamCombiner<ogzstream, OutputArchive> CompressedOutput;
 typedef StreamCombiner<igzstream, InputArchive> CompressedInput;
@@ -20,18 +21,20 @@ optional<pair<string, int>> getNameAndVersionUsing(const FilePath& filename) {
   }
 }
 
-inline optional<pair<string, int>> getNameAndVersion(const FilePath& filename) {
-  return getNameAndVersionUsing<CompressedInput>(filename);
-}
+// Saves are written as a SectionedOutput with these sections. Files from before the sectioned format are a single
+// compressed stream that starts with the same header. Only the header is still read from them, so that they are
+// listed as incompatible, since their save versions are all below the first sectioned one.
+constexpr const char* saveHeaderSection = "header";
+constexpr const char* saveInfoSection = "info";
+constexpr const char* saveDataSection = "data";
 
-template <typename InputType>
-optional<SavedGameInfo> getSavedGameInfoUsing(const FilePath& filename) {
+inline optional<pair<string, int>> getNameAndVersion(const FilePath& filename) {
+  if (!SectionedInput::isSectioned(filename))
+    return getNameAndVersionUsing<CompressedInput>(filename);
   try {
-    InputType input(filename.getPath());
-    string discard2;
-    int discard;
-    SavedGameInfo ret;
-    input.getArchive() >> discard >> discard2 >> ret;
+    SectionedInput input(filename);
+    pair<string, int> ret;
+    input.readSection(saveHeaderSection, ret.second, ret.first);
     return ret;
   } catch (std::exception&) {
     return none;
@@ -39,7 +42,16 @@ optional<SavedGameInfo> getSavedGameInfoUsing(const FilePath& filename) {
 }
 
 inline optional<SavedGameInfo> loadSavedGameInfo(const FilePath& filename) {
-  return getSavedGameInfoUsing<CompressedInput>(filename);
+  if (!SectionedInput::isSectioned(filename))
+    return none;
+  try {
+    SectionedInput input(filename);
+    SavedGameInfo ret;
+    input.readSection(saveInfoSection, ret);
+    return ret;
+  } catch (std::exception&) {
+    return none;
+  }
 }
 
 
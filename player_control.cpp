@@ -101,6 +101,7 @@
 #include "item_types.h"
 #include "furnace.h"
 #include "promotion_info.h"
+#include "clock.h"
 
 template <class Archive>
 void PlayerControl::serialize(Archive& ar, const unsigned int version) {
@@ -574,21 +575,28 @@ static CollectiveInfo::PromotionOption getPromotionOption(const ContentFactory*
   return {info.viewId, info.name, info.applied.getDescription(factory)};
 }
 
-void PlayerControl::fillPromotions(Creature* creature, CollectiveInfo& info) const {
-  CollectiveInfo::MinionPromotionInfo promotionInfo;
-  promotionInfo.viewId = creature->getViewObject().getViewIdList();
-  promotionInfo.name = creature->getName().firstOrBare();
-  promotionInfo.id = creature->getUniqueId();
-  promotionInfo.canAdvance = creature->getPromotions().size() < creature->getAttributes().maxPromotions &&
-      collective->getDungeonLevel().numPromotionsAvailable() > 0;
-  for (auto& promotion : creature->getPromotions())
-    promotionInfo.promotions.push_back(getPromotionOption(getGame()->getContentFactory(), promotion));
-  auto contentFactory = getGame()->getContentFactory();
+void PlayerControl::fillPromotions(CollectiveInfo& info) const {
+  vector<CollectiveInfo::MinionPromotionInfo> minionPromotions;
+  info.availablePromotions = 0;
+  for (auto creature : collective->getCreatures()) {
+    if (!creature->getAttributes().promotionGroup)
+      continue;
+    CollectiveInfo::MinionPromotionInfo promotionInfo;
+    promotionInfo.viewId = creature->getViewObject().getViewIdList();
+    promotionInfo.name = creature->getName().firstOrBare();
+    promotionInfo.id = creature->getUniqueId();
+    promotionInfo.canAdvance = creature->getPromotions().size() < creature->getAttributes().maxPromotions &&
+        collective->getDungeonLevel().numPromotionsAvailable() > 0;
+    for (auto& promotion : creature->getPromotions())
+      promotionInfo.promotions.push_back(getPromotionOption(getGame()->getContentFactory(), promotion));
+    auto contentFactory = getGame()->getContentFactory();
     for (auto& promotion : contentFactory->promotions.at(*creature->getAttributes().promotionGroup))
-        promotionInfo.options.push_back(getPromotionOption(contentFactory, promotion));
-    info.minionPromotions.push_back(std::move(promotionInfo));
-  info.availablePromotions = int(0.001
-      + double(collective->getDungeonLevel().numPromotionsAvailable()) / creature->getAttributes().promotionCost);
+      promotionInfo.options.push_back(getPromotionOption(contentFactory, promotion));
+    minionPromotions.push_back(std::move(promotionInfo));
+    info.availablePromotions = int(0.001
+        + double(collective->getDungeonLevel().numPromotionsAvailable()) / creature->getAttributes().promotionCost);
+  }
+  info.minionPromotions = std::move(minionPromotions);
 }
 
 static ItemInfo getEmptySteedItemInfo(const ContentFactory* factory) {
@@ -1838,7 +1846,7 @@ void PlayerControl::fillImmigration(CollectiveInfo& info) const {
 }
 
 void PlayerControl::fillImmigrationHelp(CollectiveInfo& info) const {
-  info.allImmigration.clear();
+  vector<ImmigrantDataInfo> allImmigration;
   auto contentFactory = getGame()->getContentFactory();
   static map<CreatureId, PCreature> creatureStats;
   auto getStats = [&](CreatureId id) -> Creature* {
@@ -1910,25 +1918,26 @@ void PlayerControl::fillImmigrationHelp(CollectiveInfo& info) const {
     for (auto trait : elem->getTraits())
       if (auto desc = getImmigrantDescription(trait))
         infoLines.push_back(desc);
-    info.allImmigration.push_back(ImmigrantDataInfo());
-    info.allImmigration.back().requirements = requirements;
-    info.allImmigration.back().info = infoLines;
-    info.allImmigration.back().cost = costObj;
-    info.allImmigration.back().creature = getImmigrantCreatureInfo(c, contentFactory);
-    info.allImmigration.back().id = elem.index();
-    info.allImmigration.back().autoState = collective->getImmigration().getAutoState(elem.index());
+    allImmigration.push_back(ImmigrantDataInfo());
+    allImmigration.back().requirements = requirements;
+    allImmigration.back().info = infoLines;
+    allImmigration.back().cost = costObj;
+    allImmigration.back().creature = getImmigrantCreatureInfo(c, contentFactory);
+    allImmigration.back().id = elem.index();
+    allImmigration.back().autoState = collective->getImmigration().getAutoState(elem.index());
   }
   if (collective->getConfig().canCapturePrisoners()) {
-    info.allImmigration.push_back(ImmigrantDataInfo());
-    info.allImmigration.back().requirements = {"Requires 2 prison tiles", "Requires knocking out a hostile creature"};
-    info.allImmigration.back().info = {"Supplies your imp force", "Can be converted to your side using torture"};
-    info.allImmigration.back().creature = ImmigrantCreatureInfo {
+    allImmigration.push_back(ImmigrantDataInfo());
+    allImmigration.back().requirements = {"Requires 2 prison tiles", "Requires knocking out a hostile creature"};
+    allImmigration.back().info = {"Supplies your imp force", "Can be converted to your side using torture"};
+    allImmigration.back().creature = ImmigrantCreatureInfo {
         "prisoner",
         {ViewId("prisoner")},
         {}
     };
-    info.allImmigration.back().id =-1;
+    allImmigration.back().id =-1;
   }
+  info.allImmigration = std::move(allImmigration);
 }
 
 static optional<CollectiveInfo::RebellionChance> getRebellionChance(double prob) {
@@ -1974,6 +1983,26 @@ void PlayerControl::fillResources(CollectiveInfo& info) const {
     }
 }
 
+void PlayerControl::fillTasks(CollectiveInfo& info) const {
+  PROFILE;
+  vector<CollectiveInfo::Task> taskMap;
+  for (const Task* task : collective->getTaskMap().getAllTasks()) {
+    optional<UniqueEntity<Creature>::Id> creature;
+    if (auto c = collective->getTaskMap().getOwner(task))
+      creature = c->getUniqueId();
+    taskMap.push_back(CollectiveInfo::Task{task->getDescription(), creature, collective->getTaskMap().isPriorityTask(task)});
+    if (taskMap.size() > 200)
+      break;
+  }
+  info.taskMap = std::move(taskMap);
+}
+
+void PlayerControl::markGameInfoDirty(EnumSet<GameInfoSection> sections) {
+  for (auto section : ENUM_ALL(GameInfoSection))
+    if (sections.contains(section))
+      gameInfoCache.dirty.insert(section);
+}
+
 void PlayerControl::refreshGameInfo(GameInfo& gameInfo) const {
   PROFILE;
   auto contentFactory = getGame()->getContentFactory();
@@ -2003,10 +2032,37 @@ void PlayerControl::refreshGameInfo(GameInfo& gameInfo) const {
   gameInfo.infoType = GameInfo::InfoType::BAND;
   gameInfo.playerInfo = CollectiveInfo();
   auto& info = *gameInfo.playerInfo.getReferenceMaybe<CollectiveInfo>();
-  info.buildings = fillButtons();
-  fillMinions(info);
+  auto& cache = gameInfoCache;
+  auto realTime = Clock::getRealMillis();
+  if (!cache.nextFullRefresh || realTime >= *cache.nextFullRefresh) {
+    cache.nextFullRefresh = realTime + milliseconds{1000};
+    cache.dirty = EnumSet<GameInfoSection>::fullSet();
+  }
+  auto& cached = cache.info;
+  if (cache.dirty.contains(GameInfoSection::BUTTONS))
+    cached.buildings = fillButtons();
+  if (cache.dirty.contains(GameInfoSection::MINIONS)) {
+    fillMinions(cached);
+    fillPromotions(cached);
+  }
+  if (cache.dirty.contains(GameInfoSection::IMMIGRATION_HELP))
+    fillImmigrationHelp(cached);
+  if (cache.dirty.contains(GameInfoSection::TASKS))
+    fillTasks(cached);
+  cache.dirty.clear();
+  // These only share the cached vectors.
+  info.buildings = cached.buildings;
+  info.minionGroups = cached.minionGroups;
+  info.automatonGroups = cached.automatonGroups;
+  info.minions = cached.minions;
+  info.minionCount = cached.minionCount;
+  info.minionLimit = cached.minionLimit;
+  info.populationString = cached.populationString;
+  info.minionPromotions = cached.minionPromotions;
+  info.availablePromotions = cached.availablePromotions;
+  info.allImmigration = cached.allImmigration;
+  info.taskMap = cached.taskMap;
   fillImmigration(info);
-  fillImmigrationHelp(info);
   info.chosenCreature.reset();
   if (chosenCreature)
     if (Creature* c = getCreature(chosenCreature->id)) {
@@ -2019,11 +2075,6 @@ void PlayerControl::refreshGameInfo(GameInfo& gameInfo) const {
     }
   fillWorkshopInfo(info);
   fillLibraryInfo(info);
-  info.minionPromotions.clear();
-  info.availablePromotions = 0;
-  for (auto c : collective->getCreatures())
-    if (c->getAttributes().promotionGroup)
-      fillPromotions(c, info);
   info.monsterHeader = info.populationString + ": " + toString(info.minionCount) + " / " + toString(info.minionLimit);
   fillDungeonLevel(info.avatarLevelInfo);
   fillResources(info);
@@ -2044,15 +2095,6 @@ void PlayerControl::refreshGameInfo(GameInfo& gameInfo) const {
       info.teams.back().highlight = true;
   }
   gameInfo.messageBuffer = messages;
-  info.taskMap.clear();
-  for (const Task* task : collective->getTaskMap().getAllTasks()) {
-    optional<UniqueEntity<Creature>::Id> creature;
-    if (auto c = collective->getTaskMap().getOwner(task))
-      creature = c->getUniqueId();
-    info.taskMap.push_back(CollectiveInfo::Task{task->getDescription(), creature, collective->getTaskMap().isPriorityTask(task)});
-    if (info.taskMap.size() > 200)
-      break;
-  }
   const auto maxEnemyCountdown = 500_visible;
   if (auto& enemies = getModel()->getExternalEnemies())
     if (auto nextWave = enemies->getNextWave()) {
@@ -2157,6 +2199,18 @@ void PlayerControl::onEvent(const GameEvent& event) {
         if (getCreatures().contains(info.creature))
           updateMinionVisibility(info.creature);
       },
+      [&](const ItemsPickedUp& info) {
+        if (collective->getCreatures().contains(info.creature))
+          markGameInfoDirty({GameInfoSection::BUTTONS});
+      },
+      [&](const ItemsDropped& info) {
+        if (collective->getCreatures().contains(info.creature))
+          markGameInfoDirty({GameInfoSection::BUTTONS});
+      },
+      [&](const ItemsAppeared& info) {
+        if (collective->getTerritory().contains(info.position))
+          markGameInfoDirty({GameInfoSection::BUTTONS});
+      },
       [&](const ItemsOwned& info) {
         auto& equipment = collective->getMinionEquipment();
         if (getCreatures().contains(info.creature))
@@ -2184,6 +2238,7 @@ void PlayerControl::onEvent(const GameEvent& event) {
               (int) collective->getDangerLevel() + collective->getPoints());
       },
       [&](const TechbookRead& info) {
+        markGameInfoDirty({GameInfoSection::BUTTONS, GameInfoSection::IMMIGRATION_HELP});
         auto tech = info.technology;
         vector<TechId> nextTechs = collective->getTechnology().getNextTechs();
         if (!collective->getTechnology().researched.count(tech)) {
@@ -2557,6 +2612,8 @@ void PlayerControl::setChosenTeam(optional<TeamId> team, optional<UniqueEntity<C
 }
 
 void PlayerControl::clearChosenInfo() {
+  // Minion groups highlight the chosen creature's group.
+  markGameInfoDirty({GameInfoSection::MINIONS});
   setChosenWorkshop(none);
   chosenCreature = none;
   chosenTeam = none;
@@ -2581,6 +2638,16 @@ void PlayerControl::setChosenWorkshop(optional<ChosenWorkshopInfo> info) {
   refreshHighlights();
 }
 
+// Marks the tasks and activity spots that get the CREATURE_DROP highlight while a minion is dragged.
+void PlayerControl::refreshDropHighlights() {
+  for (auto task : collective->getTaskMap().getAllTasks())
+    if (auto pos = collective->getTaskMap().getPosition(task))
+      pos->setNeedsRenderUpdate(true);
+  for (auto task : ENUM_ALL(MinionActivity))
+    for (auto& pos : collective->getMinionActivities().getAllPositions(collective, nullptr, task))
+      pos.first.setNeedsRenderUpdate(true);
+}
+
 void PlayerControl::minionDragAndDrop(Vec2 v, variant<string, UniqueEntity<Creature>::Id> who) {
   PROFILE;
   Position pos(v, getCurrentLevel());
@@ -2646,6 +2713,7 @@ void PlayerControl::handleBanishing(Creature* c) {
 }
 
 void PlayerControl::processInput(View* view, UserInput input) {
+  markGameInfoDirty();
   switch (input.getId()) {
     case UserInputId::MESSAGE_INFO:
       if (auto message = findMessage(input.get<PlayerMessage::Id>())) {
@@ -2680,23 +2748,20 @@ void PlayerControl::processInput(View* view, UserInput input) {
     }
     case UserInputId::CREATURE_DRAG:
       draggedCreature = input.get<Creature::Id>();
-      for (auto task : collective->getTaskMap().getAllTasks())
-        if (auto pos = collective->getTaskMap().getPosition(task))
-          pos->setNeedsRenderUpdate(true);
-      for (auto task : ENUM_ALL(MinionActivity))
-        for (auto& pos : collective->getMinionActivities().getAllPositions(collective, nullptr, task))
-          pos.first.setNeedsRenderUpdate(true);
+      refreshDropHighlights();
       break;
     case UserInputId::CREATURE_DRAG_DROP: {
       auto info = input.get<CreatureDropInfo>();
       minionDragAndDrop(info.pos, info.creatureId);
       draggedCreature = none;
+      refreshDropHighlights();
       break;
     }
     case UserInputId::CREATURE_GROUP_DRAG_ON_MAP: {
       auto info = input.get<CreatureGroupDropInfo>();
       minionDragAndDrop(info.pos, info.group);
       draggedCreature = none;
+      refreshDropHighlights();
       break;
     }
     case UserInputId::TEAM_DRAG_DROP: {
@@ -3843,6 +3908,7 @@ void PlayerControl::onMemberKilledOrStunned(Creature* victim, const Creature* ki
       (!collective->hasTrait(victim, MinionTrait::LEADER) || collective->getCreatures(MinionTrait::LEADER).size() > 1))
     onControlledKilled(victim);
   visibilityMap->remove(victim);
+  markGameInfoDirty({GameInfoSection::MINIONS, GameInfoSection::TASKS});
   if (victim->isDead())
     battleSummary.minionsKilled.push_back(victim);
   else
@@ -3851,12 +3917,25 @@ void PlayerControl::onMemberKilledOrStunned(Creature* victim, const Creature* ki
 
 void PlayerControl::onMemberAdded(Creature* c) {
   updateMinionVisibility(c);
+  markGameInfoDirty({GameInfoSection::MINIONS});
   auto team = getControlled();
   if (collective->hasTrait(c, MinionTrait::PRISONER) && !team.empty() &&
       team[0]->getPosition().isSameLevel(c->getPosition()))
     addToCurrentTeam(c);
 }
 
+void PlayerControl::onMemberRemoved(Creature*) {
+  markGameInfoDirty({GameInfoSection::MINIONS, GameInfoSection::TASKS});
+}
+
+void PlayerControl::onResourcesChanged() {
+  markGameInfoDirty({GameInfoSection::BUTTONS});
+}
+
+void PlayerControl::onTasksChanged() {
+  markGameInfoDirty({GameInfoSection::TASKS});
+}
+
 Model* PlayerControl::getModel() const {
   return collective->getModel();
 }
@@ -3888,6 +3967,7 @@ void PlayerControl::updateSquareMemory(Position pos) {
 
 void PlayerControl::onConstructed(Position pos, FurnitureType type) {
   addToMemory(pos);
+  markGameInfoDirty({GameInfoSection::BUTTONS, GameInfoSection::TASKS});
   if (getGame()->getContentFactory()->furniture.getData(type).isEyeball())
     visibilityMap->updateEyeball(pos);
 }
@@ -3928,6 +4008,7 @@ CollectiveControl::DuelAnswer PlayerControl::acceptDuel(Creature* attacker) {
 }
 
 void PlayerControl::onDestructed(Position pos, FurnitureType type, const DestroyAction& action) {
+  markGameInfoDirty({GameInfoSection::BUTTONS, GameInfoSection::TASKS});
   if (action.getType() == DestroyAction::Type::DIG) {
     Vec2 visRadius(3, 3);
     for (Position v : pos.getRectangle(Rectangle(-visRadius, visRadius + Vec2(1, 1)))) {
@@ -59,6 +59,14 @@ namespace BuildInfoTypes {
   struct BuildType;
 }
 
+RICH_ENUM(
+  GameInfoSection,
+  BUTTONS,
+  MINIONS,
+  IMMIGRATION_HELP,
+  TASKS
+);
+
 class PlayerControl : public CreatureView, public CollectiveControl, public EventListener<PlayerControl> {
   public:
   static PPlayerControl create(Collective* col, vector<string> introText, TribeAlignment);
@@ -136,6 +144,9 @@ class PlayerControl : public CreatureView, public CollectiveControl, public Even
   virtual void onMemberKilledOrStunned(Creature* victim, const Creature* killer) override;
   virtual void onConquered(Creature* victim, Creature* killer) override;
   virtual void onMemberAdded(Creature*) override;
+  virtual void onMemberRemoved(Creature*) override;
+  virtual void onResourcesChanged() override;
+  virtual void onTasksChanged() override;
   virtual void onConstructed(Position, FurnitureType) override;
   virtual void onDestructed(Position, FurnitureType, const DestroyAction&) override;
   virtual void onClaimedSquare(Position) override;
@@ -195,6 +206,7 @@ class PlayerControl : public CreatureView, public CollectiveControl, public Even
   void equipmentGroupAction(const EquipmentGroupAction&);
   void minionAIAction(const AIActionInfo&);
   void minionDragAndDrop(Vec2 pos, variant<string, UniqueEntity<Creature>::Id>);
+  void refreshDropHighlights();
   void fillMinions(CollectiveInfo&) const;
   vector<Creature*> getMinionGroup(const string& groupName) const;
   vector<PlayerInfo> getPlayerInfos(vector<Creature*>) const;
@@ -207,7 +219,7 @@ class PlayerControl : public CreatureView, public CollectiveControl, public Even
   void handleEquipment(View* view, Creature* creature);
   void fillSteedInfo(Creature*, PlayerInfo&) const;
   void fillEquipment(Creature*, PlayerInfo&) const;
-  void fillPromotions(Creature*, CollectiveInfo&) const;
+  void fillPromotions(CollectiveInfo&) const;
   void handleTrading(Collective* ally);
   vector<Item*> getPillagedItems(Collective*) const;
   void handlePillage(Collective* enemy);
@@ -286,6 +298,17 @@ class PlayerControl : public CreatureView, public CollectiveControl, public Even
   vector<pair<Item*, Position>> getItemUpgradesFor(const WorkshopItem&) const;
   void fillDungeonLevel(AvatarLevelInfo&) const;
   void fillResources(CollectiveInfo&) const;
+  void fillTasks(CollectiveInfo&) const;
+  // Sections of CollectiveInfo that are expensive to fill are kept between calls to refreshGameInfo. A section is
+  // filled again after an event or user input that could change it. Changes that no event reports, like minion
+  // stats, are picked up by filling all sections at most once per second of real time.
+  struct GameInfoCache {
+    EnumSet<GameInfoSection> dirty = EnumSet<GameInfoSection>::fullSet();
+    optional<milliseconds> nextFullRefresh;
+    CollectiveInfo info;
+  };
+  mutable GameInfoCache gameInfoCache;
+  void markGameInfoDirty(EnumSet<GameInfoSection> = EnumSet<GameInfoSection>::fullSet());
   bool takingScreenshot = false;
   void addBodyPart(Creature*);
   void handleBanishing(Creature*);
@@ -74,7 +74,7 @@ bool PlayerMessage::isClickable() const {
 }
 
 int PlayerMessage::getHash() const {
-  return combineHash(text, priority, freshness);
+  return combineHash(text, priority, freshness, getUniqueId(), isClickable());
 }
 
 SERIALIZE_DEF(PlayerMessage, SUBCLASS(UniqueEntity), text, priority, freshness, announcementTitle, position, creature)
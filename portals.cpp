@@ -37,7 +37,7 @@ void Portals::recalculateDistances(Level* level) {
   };
   Dijkstra dijkstra(ret.getBounds(), portals, 10000, entryFun);
   for (auto& pos : dijkstra.getAllReachable())
-    ret[pos.first] = (short) pos.second;
+    ret[pos] = (short) dijkstra.getDist(pos);
   distanceToNearest.insert(make_pair(level->getUniqueId(), std::move(ret)));
 }
 
@@ -245,6 +245,7 @@ void Position::registerPortal() {
       if (isSameLevel(*other)) {
         for (auto& sectors : level->sectors)
           sectors.second.addExtraConnection(coord, other->coord);
+        level->flowFields->clear();
       } else {
         auto key = StairKey::getNew();
         setLandingLink(key);
@@ -262,6 +263,7 @@ void Position::removePortal() {
       if (isSameLevel(*other)) {
         for (auto& sectors : level->sectors)
           sectors.second.removeExtraConnection(coord, other->coord);
+        level->flowFields->clear();
       } else {
         removeLandingLink();
         other->removeLandingLink();
@@ -1061,6 +1063,7 @@ void Position::updateConnectivity() const {
         elem.second.add(coord);
       else
         elem.second.remove(coord);
+    level->flowFields->squareChanged(coord);
   }
   if (couldEnter != movementEventPredicate())
     if (auto game = getGame())
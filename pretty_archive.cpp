@@ -277,7 +277,7 @@ PrettyInputArchive::PrettyInputArchive(const vector<string>& inputs, const vecto
   }
   auto res = preprocess(allInput);
   streamPos = res.transform([](auto& elem) { return elem.pos; });
-  is.str(getString(res));
+  input = getString(res);
 }
 
 static auto getOpenBracket(BracketType type) {
@@ -303,32 +303,129 @@ void PrettyInputArchive::closeBracket(BracketType type) {
 }
 
 bool PrettyInputArchive::isOpenBracket(BracketType type) {
-  return peek() == getOpenBracket(type);
+  return isNextToken(getOpenBracket(type));
 }
 
 bool PrettyInputArchive::isCloseBracket(BracketType type) {
-  return peek() == getCloseBracket(type);
+  return isNextToken(getCloseBracket(type));
+}
+
+static bool isWhitespace(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+void PrettyInputArchive::skipWhitespace() {
+  while (position < input.size() && isWhitespace(input[position]))
+    ++position;
+}
+
+int PrettyInputArchive::scanToken(int& pos, int& begin) const {
+  while (pos < input.size() && isWhitespace(input[pos]))
+    ++pos;
+  begin = pos;
+  while (pos < input.size() && !isWhitespace(input[pos]))
+    ++pos;
+  return pos - begin;
 }
 
 string PrettyInputArchive::eat(const char* expected) {
-  string s;
-  is >> s;
-  if (!is) {
-    if (is.eof())
-      error("Unexpected end of file");
-    if (is.fail())
-      error("Failure " + is.str());
-    if (is.bad())
-      error("IO Failure");
+  int begin;
+  int length = scanToken(position, begin);
+  if (length == 0)
+    error("Unexpected end of file");
+  if (expected != nullptr && input.compare(begin, length, expected) != 0)
+    error("Expected \""_s + expected + "\", got \"" + input.substr(begin, length) + "\"");
+  return input.substr(begin, length);
+}
+
+bool PrettyInputArchive::readValue(string& s) {
+  int begin;
+  int length = scanToken(position, begin);
+  if (length == 0)
+    return false;
+  s.assign(input, begin, length);
+  return true;
+}
+
+bool PrettyInputArchive::readValue(QuotedText quoted) {
+  const char delim = '"';
+  const char escape = '\\';
+  skipWhitespace();
+  if (position >= input.size())
+    return false;
+  if (input[position] != delim)
+    return readValue(quoted.text);
+  ++position;
+  quoted.text.clear();
+  while (position < input.size()) {
+    char c = input[position++];
+    if (c == escape) {
+      if (position >= input.size())
+        return false;
+      c = input[position++];
+    } else if (c == delim)
+      return true;
+    quoted.text += c;
   }
-  if (expected != nullptr && s != expected)
-    error("Expected \""_s + expected + "\", got \"" + s + "\"");
-  return s;
+  return false;
+}
+
+// Numbers are parsed like operator >> does, so a number can end in the middle of a word, and the rest of the word
+// is read next.
+template <typename T, typename Fun>
+static bool parseNumber(const string& input, int& position, T& value, Fun parse) {
+  const char* begin = input.c_str() + position;
+  const char* digits = begin;
+  if (*digits == '-' || *digits == '+')
+    ++digits;
+  if (!isdigit((unsigned char) *digits) && (*digits != '.' || !std::is_floating_point<T>::value))
+    return false;
+  char* end;
+  errno = 0;
+  value = parse(begin, &end);
+  if (end == begin || errno == ERANGE)
+    return false;
+  position += end - begin;
+  return true;
+}
+
+bool PrettyInputArchive::readNumber(long long& value) {
+  skipWhitespace();
+  return parseNumber(input, position, value, [](const char* s, char** end) { return strtoll(s, end, 10); });
+}
+
+bool PrettyInputArchive::readNumber(unsigned long long& value) {
+  skipWhitespace();
+  return parseNumber(input, position, value, [](const char* s, char** end) { return strtoull(s, end, 10); });
+}
+
+bool PrettyInputArchive::readNumber(float& value) {
+  skipWhitespace();
+  return parseNumber(input, position, value, [](const char* s, char** end) { return strtof(s, end); });
+}
+
+bool PrettyInputArchive::readNumber(double& value) {
+  skipWhitespace();
+  return parseNumber(input, position, value, [](const char* s, char** end) { return strtod(s, end); });
+}
+
+bool PrettyInputArchive::readNumber(long double& value) {
+  skipWhitespace();
+  return parseNumber(input, position, value, [](const char* s, char** end) { return strtold(s, end); });
+}
+
+bool PrettyInputArchive::readNumber(char& value) {
+  skipWhitespace();
+  if (position >= input.size())
+    return false;
+  value = input[position++];
+  return true;
 }
 
 StreamPosStack PrettyInputArchive::getCurrentPosition() {
-  int n = (int) is.tellg();
-  return streamPos.empty() ? StreamPosStack() : streamPos[max(0, min<int>(n, streamPos.size() - 1))];
+  // There is no character to point to at the end of the input, so the beginning is reported instead.
+  int n = position < input.size() ? position : 0;
+  return streamPos.empty() ? StreamPosStack() : streamPos[min<int>(n, streamPos.size() - 1)];
 }
 
 void PrettyInputArchive::error(const string& s) {
@@ -336,7 +433,7 @@ void PrettyInputArchive::error(const string& s) {
 }
 
 bool PrettyInputArchive::eatMaybe(const string& s) {
-  if (peek() == s) {
+  if (isNextToken(s.c_str())) {
     eat();
     return true;
   } else
@@ -345,19 +442,30 @@ bool PrettyInputArchive::eatMaybe(const string& s) {
 
 string PrettyInputArchive::peek(int cnt) {
   string s;
-  auto bookmark = is.tellg();
-  for (int i : Range(cnt))
-    is >> s;
-  is.seekg(bookmark);
+  int pos = position;
+  for (int i : Range(cnt)) {
+    int begin;
+    if (int length = scanToken(pos, begin))
+      s.assign(input, begin, length);
+    else
+      break;
+  }
   return s;
 }
 
+bool PrettyInputArchive::isNextToken(const char* s) {
+  int pos = position;
+  int begin;
+  int length = scanToken(pos, begin);
+  return input.compare(begin, length, s) == 0;
+}
+
 long PrettyInputArchive::bookmark() {
-  return is.tellg();
+  return position;
 }
 
 void PrettyInputArchive::seek(long p) {
-  is.seekg(p);
+  position = p;
 }
 
 void PrettyInputArchive::startNode() {
@@ -380,7 +488,7 @@ void prettyEpilogue(PrettyInputArchive& ar1) {
     bool keysAndValues = false;
     set<string> processed;
     while (!ar1.isCloseBracket(bracket)) {
-      if (ar1.peek() == ",")
+      if (ar1.isNextToken(","))
         ar1.eat();
       auto bookmark = ar1.bookmark();
       string name, equals;
@@ -407,7 +515,7 @@ void prettyEpilogue(PrettyInputArchive& ar1) {
             ar1.error("Value defined twice: \"" + name + "\"");
           processed.insert(name);
           bool initialize = true;
-          if (ar1.peek() == "append") {
+          if (ar1.isNextToken("append")) {
             if (!appending)
               ar1.error("Can't append to value that wasn't inherited");
             initialize = false;
@@ -435,7 +543,7 @@ void serialize(PrettyInputArchive& ar, string& t) {
     string tmp = ar.peek();
     if (isdigit(tmp[0])) {
       int value;
-      ar.is >> value;
+      ar.readText(value);
       t += toString(value);
       if (!ar.eatMaybe("+"))
         break;
@@ -443,7 +551,7 @@ void serialize(PrettyInputArchive& ar, string& t) {
       if (tmp[0] != '\"')
         ar.error("Expected quoted string, got: " + tmp);
       string next;
-      ar.readText(std::quoted(next));
+      ar.readText(PrettyInputArchive::QuotedText{next});
       t += next;
       if (!ar.eatMaybe("+"))
         break;
@@ -453,7 +561,7 @@ void serialize(PrettyInputArchive& ar, string& t) {
 
 void serialize(PrettyInputArchive& ar, char& c) {
   string s;
-  ar.readText(std::quoted(s));
+  ar.readText(PrettyInputArchive::QuotedText{s});
   if (s[0] == '0')
     c = '\0';
   else
@@ -503,22 +611,19 @@ struct Expression {
   PrettyInputArchive& ar;
 
   char pop() {
-    char c = ' ';
-    while (isspace(c))
-      c = ar.is.get();
-    return c;
+    ar.skipWhitespace();
+    return ar.position < ar.input.size() ? ar.input[ar.position++] : EOF;
   }
 
   char peek() {
-    while (isspace(ar.is.peek()))
-      ar.is.get();
-    return ar.is.peek();
+    ar.skipWhitespace();
+    return ar.position < ar.input.size() ? ar.input[ar.position] : EOF;
   }
 
   int factor() {
     if (isdigit(peek()) || peek() == '-') {
-      int result;
-      ar.is >> result;
+      int result = 0;
+      ar.readValue(result);
       return result;
     } else
     if (peek() == '(') {
@@ -55,9 +55,7 @@ class PrettyInputArchive {
     template <typename T>
     bool readMaybe(T& elem) {
       auto b = bookmark();
-      is >> elem;
-      if (!is) {
-        is.clear();
+      if (!readValue(elem)) {
         seek(b);
         return false;
       }
@@ -70,19 +68,23 @@ class PrettyInputArchive {
     bool isOpenBracket(BracketType);
     bool isCloseBracket(BracketType);
     string peek(int cnt = 1);
+    // Same as peek() == s, without copying the token.
+    bool isNextToken(const char* s);
 
     template <typename T>
     PrettyInputArchive& readText(T&& elem) {
       auto b = bookmark();
-      is >> std::forward<T>(elem);
-      if (!is) {
-        is.clear();
+      if (!readValue(std::forward<T>(elem))) {
         seek(b);
         error("Error reading value of type: "_s + typeid(T).name());
       }
       return *this;
     }
 
+    struct QuotedText {
+      string& text;
+    };
+
     long bookmark();
 
     template <typename T>
@@ -124,8 +126,37 @@ class PrettyInputArchive {
     //private:
     vector<NodeData> nodeData;
     bool nextElemInherited = false;
-    std::istringstream is;
+    // The preprocessed input and the position of each of its characters in the original files. Values are read
+    // directly from the buffer and bookmarks are just indices into it.
+    string input;
+    int position = 0;
     vector<StreamPosStack> streamPos;
+    void skipWhitespace();
+    int scanToken(int& pos, int& begin) const;
+    // Reads a whitespace delimited word, like operator >> on a stream.
+    bool readValue(string&);
+    // Reads a string in quotes, like std::quoted. Falls back to a word if there is no opening quote.
+    bool readValue(QuotedText);
+    bool readNumber(long long&);
+    bool readNumber(unsigned long long&);
+    bool readNumber(float&);
+    bool readNumber(double&);
+    bool readNumber(long double&);
+    bool readNumber(char&);
+    template <typename T>
+    using NumberType = typename std::conditional<std::is_floating_point<T>::value, T,
+        typename std::conditional<sizeof(T) == 1, char,
+        typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type>::type>::type;
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value, bool>::type readValue(T& elem) {
+      NumberType<T> value;
+      if (!readNumber(value))
+        return false;
+      if (sizeof(T) > 1 && (value < std::numeric_limits<T>::lowest() || value > std::numeric_limits<T>::max()))
+        return false;
+      elem = value;
+      return true;
+    }
     vector<string> filenames;
     void throwException(const StreamPosStack&, const string&);
     string positionToString(const StreamPosStack&);
@@ -295,7 +326,7 @@ inline void serializeMap(PrettyInputArchive& ar1, M& m) {
       break;
     typename M::key_type key;
     ar1(key);
-    if (ar1.peek() != "modify" && keys.count(key))
+    if (!ar1.isNextToken("modify") && keys.count(key))
       ar1.error("Duplicate key");
     keys.insert(key);
     typename M::mapped_type value;
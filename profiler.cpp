@@ -0,0 +1,259 @@
+#include "stdafx.h"
+#include "profiler.h"
+#include "extern/optional.h"
+
+#ifndef BUILD_WITH_EASY_PROFILER
+
+#include <unordered_set>
+#include <iomanip>
+
+atomic<bool> Profiler::enabled { false };
+
+namespace {
+
+struct ProfileEvent {
+  const char* name;
+  long long start;
+  long long duration;
+};
+
+struct ProfileCounter {
+  long long count = 0;
+  long long total = 0;
+  long long max = 0;
+};
+
+// Around 6MB per thread. Old events are overwritten. The buffer is allocated on the first recorded scope and freed
+// when the trace is dumped, or when the thread exits while the profiler is off.
+constexpr int ringBufferSize = 1 << 18;
+// endTurn() doesn't read events that are this close to being overwritten, since the owning thread doesn't wait
+// for readers.
+constexpr int ringBufferMargin = ringBufferSize / 4;
+
+// Only the owning thread writes the events. Readers load numWritten with acquire ordering and read the events
+// before it.
+struct ThreadProfile {
+  int index;
+  std::vector<ProfileEvent> events;
+  atomic<long long> numWritten { 0 };
+  // Set by the owning thread while it writes an event, so that stop() can wait until nobody writes.
+  atomic<bool> writing { false };
+  bool exited = false;
+  // The following are guarded by the state mutex.
+  long long numAggregated = 0;
+};
+
+struct ProfilerState {
+  std::mutex mutex;
+  std::vector<unique_ptr<ThreadProfile>> threads;
+  int nextThreadIndex = 0;
+  std::unordered_set<string> internedNames;
+  steady_clock::time_point startTime = steady_clock::now();
+  optional<steady_clock::time_point> turnStart;
+  string pathPrefix;
+  unique_ptr<ofstream> summaryOutput;
+  std::vector<string> turnNotes;
+  string lastTurnSummary;
+};
+
+ProfilerState& getState() {
+  static ProfilerState state;
+  return state;
+}
+
+// Unregisters the thread's profile when the thread exits. If the profiler is running the events are kept until
+// the trace is dumped.
+struct ThreadProfileHolder {
+  ThreadProfile* profile = nullptr;
+
+  ~ThreadProfileHolder() {
+    if (!profile)
+      return;
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (Profiler::isEnabled())
+      profile->exited = true;
+    else
+      state.threads.erase(std::find_if(state.threads.begin(), state.threads.end(),
+          [this](const auto& elem) { return elem.get() == profile; }));
+  }
+};
+
+ThreadProfile& getThreadProfile() {
+  thread_local ThreadProfileHolder holder;
+  if (!holder.profile) {
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.threads.push_back(make_unique<ThreadProfile>());
+    holder.profile = state.threads.back().get();
+    holder.profile->index = state.nextThreadIndex++;
+  }
+  return *holder.profile;
+}
+
+long long toNanos(steady_clock::duration d) {
+  return duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+string escapeJson(const char* s) {
+  string ret;
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\')
+      ret += '\\';
+    if (*s >= 0 && *s < 32)
+      ret += ' ';
+    else
+      ret += *s;
+  }
+  return ret;
+}
+
+}
+
+void Profiler::start(const string& pathPrefix) {
+  auto& state = getState();
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.pathPrefix = pathPrefix;
+    state.summaryOutput = make_unique<ofstream>(pathPrefix + "_turns.txt");
+    state.turnStart = none;
+  }
+  enabled = true;
+}
+
+const char* Profiler::intern(const char* name) {
+  thread_local unordered_map<string, const char*> cache;
+  auto it = cache.find(name);
+  if (it != cache.end())
+    return it->second;
+  auto& state = getState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  auto ret = state.internedNames.insert(name).first->c_str();
+  cache[name] = ret;
+  return ret;
+}
+
+void Profiler::record(const char* name, steady_clock::time_point start, steady_clock::time_point end) {
+  auto& profile = getThreadProfile();
+  profile.writing = true;
+  // Sequentially consistent, unlike isEnabled(), so that stop() either waits for this write or it doesn't happen.
+  if (!enabled) {
+    profile.writing = false;
+    return;
+  }
+  if (profile.events.empty())
+    profile.events.resize(ringBufferSize);
+  long long index = profile.numWritten.load(std::memory_order_relaxed);
+  profile.events[index % ringBufferSize] =
+      ProfileEvent{name, toNanos(start - getState().startTime), toNanos(end - start)};
+  profile.numWritten.store(index + 1, std::memory_order_release);
+  profile.writing = false;
+}
+
+void Profiler::endTurn(int turn) {
+  if (!isEnabled())
+    return;
+  auto& state = getState();
+  auto now = steady_clock::now();
+  unordered_map<const char*, ProfileCounter> counters;
+  std::vector<string> notes;
+  long long numDropped = 0;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    notes = std::move(state.turnNotes);
+    state.turnNotes.clear();
+    for (auto& thread : state.threads) {
+      long long numWritten = thread->numWritten.load(std::memory_order_acquire);
+      long long begin = max(thread->numAggregated, numWritten - ringBufferSize + ringBufferMargin);
+      numDropped += begin - thread->numAggregated;
+      for (long long i = begin; i < numWritten; ++i) {
+        auto& event = thread->events[i % ringBufferSize];
+        auto& counter = counters[event.name];
+        ++counter.count;
+        counter.total += event.duration;
+        counter.max = max(counter.max, event.duration);
+      }
+      thread->numAggregated = numWritten;
+    }
+  }
+  if (numDropped > 0)
+    notes.push_back(std::to_string(numDropped) + " events were overwritten before they were counted");
+  auto turnStart = state.turnStart;
+  state.turnStart = now;
+  if (!turnStart)
+    return;
+  std::vector<pair<const char*, ProfileCounter>> sorted(counters.begin(), counters.end());
+  std::sort(sorted.begin(), sorted.end(),
+      [](const auto& a, const auto& b) { return a.second.total > b.second.total; });
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "Turn " << turn << ": " << toNanos(now - *turnStart) / 1000000.0 << " ms\n";
+  out << std::setw(50) << std::left << "  block" << std::right << std::setw(10) << "count"
+      << std::setw(14) << "total ms" << std::setw(12) << "max ms" << "\n";
+  const int maxRows = 20;
+  for (int i = 0; i < sorted.size() && i < maxRows; ++i) {
+    auto& counter = sorted[i].second;
+    out << "  " << std::setw(48) << std::left << string(sorted[i].first).substr(0, 47) << std::right
+        << std::setw(10) << counter.count
+        << std::setw(14) << counter.total / 1000000.0
+        << std::setw(12) << counter.max / 1000000.0 << "\n";
+  }
+  for (auto& note : notes)
+    out << "  " << note << "\n";
+  state.lastTurnSummary = out.str();
+  if (state.summaryOutput)
+    *state.summaryOutput << state.lastTurnSummary << std::flush;
+}
+
+void Profiler::addTurnNote(const string& note) {
+  if (!isEnabled())
+    return;
+  auto& state = getState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.turnNotes.push_back(note);
+}
+
+string Profiler::getLastTurnSummary() {
+  return getState().lastTurnSummary;
+}
+
+void Profiler::stop() {
+  if (!isEnabled())
+    return;
+  enabled = false;
+  auto& state = getState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  // Threads that started writing before the flag was cleared finish their event, the others see the flag.
+  for (auto& thread : state.threads)
+    while (thread->writing)
+      std::this_thread::yield();
+  ofstream out(state.pathPrefix + "_trace.json");
+  out << std::fixed << std::setprecision(3);
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (auto& thread : state.threads) {
+    if (!first)
+      out << ",\n";
+    first = false;
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->index
+        << ",\"args\":{\"name\":\"thread " << thread->index << "\"}}";
+    long long numWritten = thread->numWritten;
+    for (long long i = max(0LL, numWritten - ringBufferSize); i < numWritten; ++i) {
+      auto& event = thread->events[i % ringBufferSize];
+      out << ",\n{\"name\":\"" << escapeJson(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->index
+          << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+    }
+  }
+  out << "\n]}\n";
+  state.summaryOutput.reset();
+  // Nothing is written while the profiler is off, so the buffers can be freed here.
+  state.threads.erase(std::remove_if(state.threads.begin(), state.threads.end(),
+      [](const auto& thread) { return thread->exited; }), state.threads.end());
+  for (auto& thread : state.threads) {
+    thread->events = std::vector<ProfileEvent>();
+    thread->numWritten = 0;
+    thread->numAggregated = 0;
+  }
+}
+
+#endif
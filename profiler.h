@@ -1,5 +1,8 @@
 #pragma once
 
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
 #ifdef EASY_PROFILER
 #define BUILD_WITH_EASY_PROFILER
 
@@ -16,8 +19,62 @@
 */
 #else
 
-#define PROFILE
-#define PROFILE_BLOCK(...)
+#include "stdafx.h"
+
+// Built-in profiler used when easy_profiler isn't linked. Scopes are only recorded after Profiler::start(),
+// otherwise they cost a single relaxed load. Every thread records into its own ring buffer without locking. The
+// buffers are summed into a per-turn summary table, and dumped as a Chrome trace (chrome://tracing) by stop().
+class Profiler {
+  public:
+  static void start(const string& pathPrefix);
+  static void stop();
+  static bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+  }
+  // Closes the current turn and appends its summary table to the summary file.
+  static void endTurn(int turn);
+  // Adds a line of text to the summary of the current turn.
+  static void addTurnNote(const string&);
+  static string getLastTurnSummary();
+  static const char* intern(const char* name);
+  static void record(const char* name, steady_clock::time_point start, steady_clock::time_point end);
+
+  private:
+  static atomic<bool> enabled;
+};
+
+class ProfileScope {
+  public:
+  // String literals and __func__ are stored as they are, other names are interned, since they might be
+  // temporary buffers.
+  template <typename T>
+  ProfileScope(const T& name) {
+    if (Profiler::isEnabled()) {
+      this->name = getStableName(name, std::is_array<T>{});
+      start = steady_clock::now();
+    }
+  }
+
+  ~ProfileScope() {
+    if (name)
+      Profiler::record(name, start, steady_clock::now());
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+
+  private:
+  static const char* getStableName(const char* name, std::true_type) {
+    return name;
+  }
+  static const char* getStableName(const char* name, std::false_type) {
+    return Profiler::intern(name);
+  }
+  const char* name = nullptr;
+  steady_clock::time_point start;
+};
+
+#define PROFILE ProfileScope PROFILE_CONCAT(profileScope, __COUNTER__)(__func__);
+#define PROFILE_BLOCK(...) ProfileScope PROFILE_CONCAT(profileScope, __COUNTER__)(__VA_ARGS__);
 #define ENABLE_PROFILER
 
 #endif
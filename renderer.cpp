@@ -29,56 +29,71 @@
 #include "tileset.h"
 #include "steam_input.h"
 
+bool Renderer::useVertexBuffer() {
+  if (!vertexBufferAvailable)
+    vertexBufferAvailable = isOpenglFeatureAvailable(OpenglFeature::VERTEX_BUFFER);
+  return *vertexBufferAvailable;
+}
+
 void Renderer::renderDeferredSprites() {
-  static vector<SDL::GLfloat> vertices;
-  static vector<SDL::GLfloat> texCoords;
-  static vector<SDL::GLfloat> colors;
-  vertices.clear();
-  texCoords.clear();
-  colors.clear();
-  auto addVertex = [&](Vec2 v, int texX, int texY, Vec2 texSize, Color color) {
-    vertices.push_back(v.x);
-    vertices.push_back(v.y);
-    texCoords.push_back(((float)texX) / texSize.x);
-    texCoords.push_back(((float)texY) / texSize.y);
-    colors.push_back(((float) color.r) / 255);
-    colors.push_back(((float) color.g) / 255);
-    colors.push_back(((float) color.b) / 255);
-    colors.push_back(((float) color.a) / 255);
-  };
-  for (auto& elem : deferredSprites) {
-    auto add = [&](Vec2 v, int texX, int texY, const DeferredSprite& draw) {
-      addVertex(v, texX, texY, draw.realSize, draw.color.value_or(Color::WHITE));
-    };
-    add(elem.a, elem.p.x, elem.p.y, elem);
-    add(elem.b, elem.k.x, elem.p.y, elem);
-    add(elem.c, elem.k.x, elem.k.y, elem);
-    add(elem.a, elem.p.x, elem.p.y, elem);
-    add(elem.c, elem.k.x, elem.k.y, elem);
-    add(elem.d, elem.p.x, elem.k.y, elem);
+  if (batch.empty())
+    return;
+  CHECK_OPENGL_ERROR();
+  const char* base = (const char*) batch.data();
+  int dataSize = batch.size() * sizeof(BatchVertex);
+  if (useVertexBuffer()) {
+    if (!vertexBuffer) {
+      vertexBuffer = 0;
+      SDL::glGenBuffers(1, &*vertexBuffer);
+    }
+    SDL::glBindBuffer(GL_ARRAY_BUFFER, *vertexBuffer);
+    // Reallocating the whole buffer lets the driver hand out fresh memory instead of waiting until the previous draw
+    // call is done with it.
+    vertexBufferSize = max(vertexBufferSize, dataSize);
+    SDL::glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, nullptr, GL_STREAM_DRAW);
+    SDL::glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, base);
+    base = nullptr;
   }
-  if (!vertices.empty()) {
-    CHECK_OPENGL_ERROR();
+  if (currentTexture) {
     SDL::glBindTexture(GL_TEXTURE_2D, *currentTexture);
     SDL::glEnable(GL_TEXTURE_2D);
-    SDL::glEnableClientState(GL_VERTEX_ARRAY);
     SDL::glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    SDL::glEnableClientState(GL_COLOR_ARRAY);
-    SDL::glColorPointer(4, GL_FLOAT, 0, colors.data());
-    SDL::glVertexPointer(2, GL_FLOAT, 0, vertices.data());
-    SDL::glTexCoordPointer(2, GL_FLOAT, 0, texCoords.data());
-    SDL::glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 2);
-    vertices.clear();
-    texCoords.clear();
-    colors.clear();
-
-    SDL::glDisableClientState(GL_VERTEX_ARRAY);
+    SDL::glTexCoordPointer(2, GL_FLOAT, sizeof(BatchVertex), base + offsetof(BatchVertex, u));
+  } else
+    SDL::glDisable(GL_TEXTURE_2D);
+  SDL::glEnableClientState(GL_VERTEX_ARRAY);
+  SDL::glEnableClientState(GL_COLOR_ARRAY);
+  SDL::glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), base + offsetof(BatchVertex, x));
+  SDL::glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), base + offsetof(BatchVertex, r));
+  SDL::glDrawArrays(GL_TRIANGLES, 0, batch.size());
+  ++frameStats.drawCalls;
+  frameStats.numVertices += batch.size();
+  SDL::glDisableClientState(GL_VERTEX_ARRAY);
+  SDL::glDisableClientState(GL_COLOR_ARRAY);
+  if (currentTexture) {
     SDL::glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-    SDL::glDisableClientState(GL_COLOR_ARRAY);
     SDL::glDisable(GL_TEXTURE_2D);
-    CHECK_OPENGL_ERROR();
   }
-  deferredSprites.clear();
+  // Other code draws from client memory, which doesn't work with a bound buffer.
+  if (vertexBuffer)
+    SDL::glBindBuffer(GL_ARRAY_BUFFER, 0);
+  CHECK_OPENGL_ERROR();
+  batch.clear();
+}
+
+void Renderer::setBatchTexture(optional<SDL::GLuint> texture) {
+  if (!batch.empty() && currentTexture != texture)
+    renderDeferredSprites();
+  currentTexture = texture;
+}
+
+void Renderer::addBatchQuad(const BatchVertex& a, const BatchVertex& b, const BatchVertex& c, const BatchVertex& d) {
+  for (auto& v : {a, b, c, a, c, d})
+    batch.push_back(v);
+}
+
+Renderer::BatchVertex Renderer::getVertex(double x, double y, Color color, float u, float v) {
+  return BatchVertex{(float) x, (float) y, u, v, color.r, color.g, color.b, color.a};
 }
 
 void Renderer::drawSprite(const Texture& t, Vec2 topLeft, Vec2 bottomRight, Vec2 p, Vec2 k, optional<Color> color) {
@@ -86,11 +101,18 @@ void Renderer::drawSprite(const Texture& t, Vec2 topLeft, Vec2 bottomRight, Vec2
 }
 
 void Renderer::drawSprite(const Texture& t, Vec2 a, Vec2 b, Vec2 c, Vec2 d, Vec2 p, Vec2 k, optional<Color> color) {
-  if (currentTexture && currentTexture != t.getTexId())
-    renderDeferredSprites();
-  currentTexture = t.getTexId();
-  CHECK(currentTexture);
-  deferredSprites.push_back({a, b, c, d, p, k, t.getRealSize(), color});
+  CHECK(t.getTexId());
+  setBatchTexture(t.getTexId());
+  auto realSize = t.getRealSize();
+  auto vertex = [&](Vec2 v, int texX, int texY) {
+    return getVertex(v.x, v.y, color.value_or(Color::WHITE), (float) texX / realSize.x, (float) texY / realSize.y);
+  };
+  addBatchQuad(vertex(a, p.x, p.y), vertex(b, k.x, p.y), vertex(c, k.x, k.y), vertex(d, p.x, k.y));
+}
+
+void Renderer::addFlatQuad(double x1, double y1, double x2, double y2, Color color) {
+  addBatchQuad(getVertex(x1, y1, color), getVertex(x2, y1, color), getVertex(x2, y2, color),
+      getVertex(x1, y2, color));
 }
 
 static float sizeConv(int size) {
@@ -182,12 +204,34 @@ Vec2 Renderer::getTextSize(const string& s, int size, FontId id) {
   }
   if (s.empty())
     return Vec2(0, 0);
-  float minx, maxx, miny, maxy;
-  int font = getFont(id);
-  sth_dim_text(fontStash, font, sizeConv(size), s.c_str(), &minx, &miny, &maxx, &maxy);
-  float height;
-  sth_vmetrics(fontStash, font, sizeConv(size), nullptr, nullptr, &height);
-  return Vec2(maxx - minx, height);
+  return getTextRun(s, size, id)->size;
+}
+
+shared_ptr<const Renderer::TextRun> Renderer::getTextRun(const string& s, int size, FontId id) {
+  ++frameStats.textLookups;
+  auto shape = [&] {
+    ++frameStats.textCacheMisses;
+    auto ret = make_shared<TextRun>();
+    ret->font = id;
+    ret->fontSize = size;
+    ret->text = s;
+    float minx, maxx, miny, maxy;
+    int font = getFont(id);
+    sth_dim_text(fontStash, font, sizeConv(size), s.c_str(), &minx, &miny, &maxx, &maxy);
+    float height;
+    sth_vmetrics(fontStash, font, sizeConv(size), nullptr, nullptr, &height);
+    ret->size = Vec2(maxx - minx, height);
+    std::vector<sth_text_quad> quads;
+    sth_get_text_quads(fontStash, font, sizeConv(size), 0, ret->size.y * 0.9, s.c_str(), quads);
+    for (auto& q : quads)
+      ret->quads.push_back(TextRun::Quad{q.texture, q.x0, q.y0, q.s0, q.t0, q.x1, q.y1, q.s1, q.t1});
+    return shared_ptr<const TextRun>(std::move(ret));
+  };
+  auto ret = textRuns->get([&](const string&, int, FontId) { return shape(); }, 0, s, size, id);
+  // The cache is keyed by a hash, so a different string can come back.
+  if (ret->text != s || ret->fontSize != size || ret->font != id)
+    return shape();
+  return ret;
 }
 
 int Renderer::getFont(FontId id) {
@@ -202,7 +246,6 @@ int Renderer::getFont(FontId id) {
 }
 
 void Renderer::drawText(FontId id, int size, Color color, Vec2 pos, const string& s, CenterType center) {
-  renderDeferredSprites();
   if (id == FontId::MAP_FONT) {
     for (auto c : s) {
       if (auto offset = getMapFontOffset(c))
@@ -213,27 +256,28 @@ void Renderer::drawText(FontId id, int size, Color color, Vec2 pos, const string
     return;
   }
   if (!s.empty()) {
-    int ox = 0;
-    int oy = 0;
-    Vec2 dim = getTextSize(s, size, id);
+    auto run = getTextRun(s, size, id);
+    int ox = pos.x;
+    int oy = pos.y;
     switch (center) {
       case HOR:
-        ox -= dim.x / 2;
+        ox -= run->size.x / 2;
         break;
       case VER:
-        oy -= dim.y / 2;
+        oy -= run->size.y / 2;
         break;
       case HOR_VER:
-        ox -= dim.x / 2;
-        oy -= dim.y / 2;
+        ox -= run->size.x / 2;
+        oy -= run->size.y / 2;
         break;
       default:
         break;
     }
-    sth_begin_draw(fontStash);
-    glColor(color);
-    sth_draw_text(fontStash, getFont(id), sizeConv(size), ox + pos.x, oy + pos.y + (dim.y * 0.9), s.c_str(), nullptr);
-    sth_end_draw(fontStash);
+    for (auto& q : run->quads) {
+      setBatchTexture(q.texture);
+      addBatchQuad(getVertex(ox + q.x0, oy + q.y0, color, q.s0, q.t0), getVertex(ox + q.x1, oy + q.y0, color, q.s1, q.t0),
+          getVertex(ox + q.x1, oy + q.y1, color, q.s1, q.t1), getVertex(ox + q.x0, oy + q.y1, color, q.s0, q.t1));
+    }
   }
 }
 
@@ -306,45 +350,34 @@ void Renderer::drawSprite(Vec2 pos, Vec2 source, Vec2 size, const Texture& t,
 }
 
 void Renderer::drawFilledRectangle(const Rectangle& t, Color color, optional<Color> outline) {
-  renderDeferredSprites();
+  setBatchTexture(none);
   Vec2 a = t.topLeft();
   Vec2 b = t.bottomRight();
   if (outline) {
-    SDL::glLineWidth(2);
-    SDL::glBegin(GL_LINE_LOOP);
-    glColor(*outline);
-    SDL::glVertex2f(a.x + 1.5f, a.y + 1.0f);
-    SDL::glVertex2f(b.x - 0.5f, a.y + 1.0f);
-    SDL::glVertex2f(b.x - 0.5f, b.y - 0.5f);
-    SDL::glVertex2f(a.x + 1.5f, b.y - 0.5f);
-    SDL::glEnd();
+    // Two pixel wide lines through (a.x + 1.5, a.y + 1) and (b.x - 0.5, b.y - 0.5).
+    addFlatQuad(a.x + 0.5, a.y, b.x + 0.5, a.y + 2, *outline);
+    addFlatQuad(a.x + 0.5, b.y - 1.5, b.x + 0.5, b.y + 0.5, *outline);
+    addFlatQuad(a.x + 0.5, a.y + 2, a.x + 2.5, b.y - 1.5, *outline);
+    addFlatQuad(b.x - 1.5, a.y + 2, b.x + 0.5, b.y - 1.5, *outline);
     a += Vec2(2, 2);
     b -= Vec2(1, 1);
   }
-  SDL::glBegin(GL_QUADS);
-  glColor(color);
-  SDL::glVertex2f(a.x, a.y);
-  SDL::glVertex2f(b.x, a.y);
-  SDL::glVertex2f(b.x, b.y);
-  SDL::glVertex2f(a.x, b.y);
-  SDL::glEnd();
+  addFlatQuad(a.x, a.y, b.x, b.y, color);
 }
 
 void Renderer::drawLine(Vec2 from, Vec2 to, Color color, double width) {
-  renderDeferredSprites();
-  SDL::glBegin(GL_QUADS);
+  setBatchTexture(none);
   double dx = to.x - from.x;
   double dy = to.y - from.y;
   double length = sqrt(dx * dx + dy * dy);
   dx /= length;
   dy /= length;
-  glColor(color);
   width /= 2;
-  SDL::glVertex2d(from.x + dy * width, from.y - dx * width);
-  SDL::glVertex2d(to.x + dy * width, to.y - dx * width);
-  SDL::glVertex2d(to.x - dy * width, to.y + dx * width);
-  SDL::glVertex2d(from.x - dy * width, from.y + dx * width);
-  SDL::glEnd();
+  addBatchQuad(
+      getVertex(from.x + dy * width, from.y - dx * width, color),
+      getVertex(to.x + dy * width, to.y - dx * width, color),
+      getVertex(to.x - dy * width, to.y + dx * width, color),
+      getVertex(from.x - dy * width, from.y + dx * width, color));
 }
 
 void Renderer::drawFilledRectangle(int px, int py, int kx, int ky, Color color, optional<Color> outline) {
@@ -352,11 +385,8 @@ void Renderer::drawFilledRectangle(int px, int py, int kx, int ky, Color color,
 }
 
 void Renderer::drawPoint(Vec2 pos, Color color, int size) {
-  SDL::glPointSize(size);
-  SDL::glBegin(GL_POINTS);
-  glColor(color);
-  SDL::glVertex2f(pos.x, pos.y);
-  SDL::glEnd();
+  setBatchTexture(none);
+  addFlatQuad(pos.x - size * 0.5, pos.y - size * 0.5, pos.x + size * 0.5, pos.y + size * 0.5, color);
 }
 
 void Renderer::addQuad(const Rectangle& r, Color color) {
@@ -404,6 +434,10 @@ void Renderer::popLayer() {
   CHECK_OPENGL_ERROR();
 }
 
+const Renderer::FrameStats& Renderer::getLastFrameStats() const {
+  return lastFrameStats;
+}
+
 Vec2 Renderer::getSize() {
   return Vec2(width / getZoom(), height / getZoom());
 }
@@ -501,7 +535,7 @@ void Renderer::initialize() {
 }
 
 void Renderer::loadFonts(const DirectoryPath& fontPath, FontSet& fonts) {
-  CHECK(fontStash = sth_create(512, 512)) << "Error initializing fonts";
+  CHECK(fontStash = sth_create(1024, 1024)) << "Error initializing fonts";
   auto textFont = fontPath.file("Lato-Bol.ttf");
   auto symbolFont = fontPath.file("Symbola.ttf");
   fonts.textFont = sth_add_font(fontStash, textFont.getPath());
@@ -533,7 +567,7 @@ void Renderer::setFpsLimit(int fps) {
 Renderer::Renderer(Clock* clock, MySteamInput* i, const string& title, const DirectoryPath& fontPath,
     const FilePath& cursorP, const FilePath& clickedCursorP, const FilePath& iconPath, const FilePath& mapFontPath)
     : cursorPath(cursorP), clickedCursorPath(clickedCursorP),
-      clock(clock), steamInput(i) {
+      textRuns(4000), clock(clock), steamInput(i) {
   CHECK(SDL::SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_EVENTS) >= 0) << SDL::SDL_GetError();
   SDL::SDL_GL_SetAttribute(SDL::SDL_GL_CONTEXT_MAJOR_VERSION, 2 );
   SDL::SDL_GL_SetAttribute(SDL::SDL_GL_CONTEXT_MINOR_VERSION, 1 );
@@ -567,7 +601,7 @@ void Renderer::drawTile(Vec2 pos, const vector<TileCoord>& coords, Vec2 size, Co
     Vec2 tileSize = scale ? coord.size * *scale : coord.size.mult(size) / nominalSize;
     if (coord.size.y > nominalSize)
       off.y -= 3 * size.y / nominalSize;
-    drawSprite(pos + off, coord.pos.mult(coord.size), coord.size, *coord.texture, tileSize, color, orientation);
+    drawSprite(pos + off, coord.pos, coord.size, *coord.texture, tileSize, color, orientation);
   };
   if (secondColor && coords.size() > 1) {
     drawCoord(coords[0], color);
@@ -673,9 +707,12 @@ void Renderer::drawAndClearBuffer() {
     steamInput->runFrame();
   renderDeferredSprites();
   CHECK_OPENGL_ERROR();
+  uint64_t end = SDL::SDL_GetPerformanceCounter();
+  float elapsedMs = (end - frameStart) / (float)SDL::SDL_GetPerformanceFrequency() * 1000.0f;
+  frameStats.cpuTimeMs = elapsedMs;
+  lastFrameStats = frameStats;
+  frameStats = FrameStats{};
   if (fpsLimit) {
-    uint64_t end = SDL::SDL_GetPerformanceCounter();
-    float elapsedMs = (end - frameStart) / (float)SDL::SDL_GetPerformanceFrequency() * 1000.0f;
     float sleepMs = 1000.0f / fpsLimit - elapsedMs;
     if (sleepMs > 0.0)
       SDL::SDL_Delay(sleepMs);
@@ -23,6 +23,7 @@
 #include "color.h"
 #include "texture.h"
 #include "font_id.h"
+#include "call_cache.h"
 
 class ViewObject;
 class Clock;
@@ -118,6 +119,15 @@ class Renderer {
   void loadAnimations();
   void makeScreenshot(const FilePath&, Rectangle bounds);
   void renderDeferredSprites();
+  struct FrameStats {
+    int drawCalls = 0;
+    int numVertices = 0;
+    int textLookups = 0;
+    int textCacheMisses = 0;
+    // Time between the start of the frame and the buffer swap, not including the wait for the fps limit.
+    float cpuTimeMs = 0;
+  };
+  const FrameStats& getLastFrameStats() const;
   MySteamInput* getSteamInput();
   Vec2 getDiscreteJoyPos(ControllerJoy);
 
@@ -164,16 +174,43 @@ class Renderer {
   SDL::SDL_Cursor* cursor;
   SDL::SDL_Cursor* cursorClicked;
   SDL::SDL_Surface* loadScaledSurface(const FilePath& path, double scale);
-  optional<SDL::GLuint> currentTexture;
   void drawSprite(const Texture& t, Vec2 a, Vec2 b, Vec2 c, Vec2 d, Vec2 p, Vec2 k, optional<Color> color);
   void drawSprite(const Texture& t, Vec2 topLeft, Vec2 bottomRight, Vec2 p, Vec2 k, optional<Color> color);
-  struct DeferredSprite {
-    Vec2 a, b, c, d;
-    Vec2 p, k;
-    Vec2 realSize;
-    optional<Color> color;
+  // Sprites, rectangles and lines are collected into a batch of triangles, which is drawn when the texture changes
+  // or something is drawn in another way. Rectangles and lines are batched with no texture.
+  struct BatchVertex {
+    float x, y;
+    float u, v;
+    Uint8 r, g, b, a;
   };
-  vector<DeferredSprite> deferredSprites;
+  static BatchVertex getVertex(double x, double y, Color, float u = 0, float v = 0);
+  void setBatchTexture(optional<SDL::GLuint>);
+  void addBatchQuad(const BatchVertex&, const BatchVertex&, const BatchVertex&, const BatchVertex&);
+  void addFlatQuad(double x1, double y1, double x2, double y2, Color);
+  // Glyph quads of a string drawn at (0, 0), and its size. All fonts share the glyph textures of the font stash,
+  // so text goes into the same batch as other sprites until a sprite from a different texture is drawn.
+  struct TextRun {
+    FontId font;
+    int fontSize;
+    string text;
+    Vec2 size;
+    struct Quad {
+      SDL::GLuint texture;
+      float x0, y0, s0, t0;
+      float x1, y1, s1, t1;
+    };
+    vector<Quad> quads;
+  };
+  shared_ptr<const TextRun> getTextRun(const string&, int size, FontId);
+  HeapAllocated<CallCache<shared_ptr<const TextRun>>> textRuns;
+  bool useVertexBuffer();
+  std::vector<BatchVertex> batch;
+  optional<SDL::GLuint> currentTexture;
+  optional<SDL::GLuint> vertexBuffer;
+  int vertexBufferSize = 0;
+  optional<bool> vertexBufferAvailable;
+  FrameStats frameStats;
+  FrameStats lastFrameStats;
   vector<Rectangle> scissorStack;
   void loadTilesFromDir(const DirectoryPath&, Vec2 size, int setWidth);
   struct TileDirectory {
@@ -0,0 +1,414 @@
+#include "stdafx.h"
+#include "sectioned_file.h"
+#include <zlib.h>
+
+static const char magic[] = "KRLSECT1";
+static constexpr int magicSize = 8;
+// Sections are compressed in chunks of this size, so that neither side has to hold a whole section in memory.
+static constexpr int chunkSize = 1 << 20;
+
+static void writeInt(ostream& out, uint32_t value) {
+  out.write((const char*) &value, sizeof(value));
+}
+
+static bool readInt(istream& in, uint32_t& value) {
+  return !!in.read((char*) &value, sizeof(value));
+}
+
+struct SectionChunk {
+  std::vector<char> raw;
+  std::vector<Bytef> compressed;
+  bool ok = false;
+};
+
+static bool compressChunk(SectionChunk& chunk) {
+  PROFILE;
+  uLongf length = compressBound(chunk.raw.size());
+  chunk.compressed.resize(length);
+  if (compress2(chunk.compressed.data(), &length, (const Bytef*) chunk.raw.data(), chunk.raw.size(),
+      Z_DEFAULT_COMPRESSION) != Z_OK)
+    return false;
+  chunk.compressed.resize(length);
+  return true;
+}
+
+static bool uncompressChunk(SectionChunk& chunk) {
+  PROFILE;
+  uLongf length = chunk.raw.size();
+  return uncompress((Bytef*) chunk.raw.data(), &length, chunk.compressed.data(), chunk.compressed.size()) == Z_OK
+      && length == chunk.raw.size();
+}
+
+static int numCompressionThreads = ThreadPool::getDefaultNumThreads();
+static unique_ptr<ThreadPool> compressionPool;
+static std::mutex compressionPoolMutex;
+
+void SectionedOutput::setCompressionThreads(int num) {
+  std::lock_guard<std::mutex> lock(compressionPoolMutex);
+  numCompressionThreads = num;
+  compressionPool.reset();
+}
+
+static ThreadPool* getCompressionPool() {
+  std::lock_guard<std::mutex> lock(compressionPoolMutex);
+  if (!compressionPool && numCompressionThreads > 1)
+    compressionPool = make_unique<ThreadPool>(numCompressionThreads);
+  return compressionPool.get();
+}
+
+// Runs the work on the chunks on the compression threads and gives the chunks back in the order they were added.
+// Without the threads the work is done right away.
+class ChunkPipeline {
+  public:
+  ChunkPipeline() : pool(getCompressionPool()), maxInFlight(pool ? 2 * pool->getNumThreads() : 1) {
+  }
+
+  ~ChunkPipeline() {
+    while (!chunks.empty())
+      popFront();
+  }
+
+  void push(shared_ptr<SectionChunk> chunk, bool (*work)(SectionChunk&)) {
+    if (!pool) {
+      chunk->ok = work(*chunk);
+      chunks.push_back({chunk, true});
+      return;
+    }
+    chunks.push_back({chunk, false});
+    auto& entry = chunks.back();
+    pool->addTask([this, &entry, chunk, work] {
+      bool ok = work(*chunk);
+      std::lock_guard<std::mutex> lock(mutex);
+      chunk->ok = ok;
+      entry.done = true;
+      chunkDone.notify_all();
+    });
+  }
+
+  shared_ptr<SectionChunk> popFront() {
+    std::unique_lock<std::mutex> lock(mutex);
+    chunkDone.wait(lock, [this] { return chunks.front().done; });
+    auto ret = std::move(chunks.front().chunk);
+    chunks.pop_front();
+    return ret;
+  }
+
+  bool isFull() const {
+    return chunks.size() >= maxInFlight;
+  }
+
+  bool isEmpty() const {
+    return chunks.empty();
+  }
+
+  private:
+  struct Entry {
+    shared_ptr<SectionChunk> chunk;
+    bool done;
+  };
+  ThreadPool* pool;
+  int maxInFlight;
+  // Entries are only added and removed on the owning thread, workers only set the done flag.
+  deque<Entry> chunks;
+  std::mutex mutex;
+  std::condition_variable chunkDone;
+};
+
+class DeflateStreamBuf : public std::streambuf {
+  public:
+  DeflateStreamBuf(ostream& out) : out(out) {
+    startChunk();
+  }
+
+  long long getSize() const {
+    return size;
+  }
+
+  long long getRawSize() const {
+    return rawSize;
+  }
+
+  virtual int overflow(int c) override {
+    if (!finishChunk())
+      return EOF;
+    if (c != EOF) {
+      *pptr() = c;
+      pbump(1);
+    }
+    return c == EOF ? 0 : c;
+  }
+
+  virtual int sync() override {
+    if (!finishChunk())
+      return -1;
+    while (!pipeline.isEmpty())
+      if (!write(*pipeline.popFront()))
+        return -1;
+    return 0;
+  }
+
+  // Compresses a chunk that was filled elsewhere.
+  bool addChunk(shared_ptr<SectionChunk> chunk) {
+    rawSize += chunk->raw.size();
+    if (pipeline.isFull() && !write(*pipeline.popFront()))
+      return false;
+    pipeline.push(std::move(chunk), &compressChunk);
+    return true;
+  }
+
+  private:
+  void startChunk() {
+    current = make_shared<SectionChunk>();
+    current->raw.resize(chunkSize);
+    setp(current->raw.data(), current->raw.data() + current->raw.size());
+  }
+
+  bool finishChunk() {
+    int length = pptr() - pbase();
+    if (length == 0)
+      return true;
+    current->raw.resize(length);
+    if (!addChunk(std::move(current)))
+      return false;
+    startChunk();
+    return true;
+  }
+
+  bool write(const SectionChunk& chunk) {
+    if (!chunk.ok)
+      return false;
+    writeInt(out, chunk.raw.size());
+    writeInt(out, chunk.compressed.size());
+    out.write((const char*) chunk.compressed.data(), chunk.compressed.size());
+    size += 2 * sizeof(uint32_t) + chunk.compressed.size();
+    return !!out;
+  }
+
+  ostream& out;
+  shared_ptr<SectionChunk> current;
+  ChunkPipeline pipeline;
+  long long size = 0;
+  long long rawSize = 0;
+};
+
+class ChunkStreamBuf : public std::streambuf {
+  public:
+  ChunkStreamBuf(std::vector<shared_ptr<SectionChunk>>& chunks) : chunks(chunks) {
+    startChunk();
+  }
+
+  virtual int overflow(int c) override {
+    finishChunk();
+    if (c != EOF) {
+      *pptr() = c;
+      pbump(1);
+    }
+    return c == EOF ? 0 : c;
+  }
+
+  virtual int sync() override {
+    finishChunk();
+    return 0;
+  }
+
+  private:
+  void startChunk() {
+    chunks.push_back(make_shared<SectionChunk>());
+    chunks.back()->raw.resize(chunkSize);
+    setp(chunks.back()->raw.data(), chunks.back()->raw.data() + chunkSize);
+  }
+
+  void finishChunk() {
+    int length = pptr() - pbase();
+    if (length == 0)
+      return;
+    chunks.back()->raw.resize(length);
+    startChunk();
+  }
+
+  std::vector<shared_ptr<SectionChunk>>& chunks;
+};
+
+class InflateStreamBuf : public std::streambuf {
+  public:
+  InflateStreamBuf(istream& in, long long size) : in(in), remaining(size) {
+    setg(nullptr, nullptr, nullptr);
+  }
+
+  virtual int underflow() override {
+    if (gptr() < egptr())
+      return (unsigned char) *gptr();
+    // Reads ahead, so that the following chunks are decompressed while the archive consumes this one.
+    while (!pipeline.isFull() && remaining > 0)
+      if (auto chunk = readChunk())
+        pipeline.push(std::move(chunk), &uncompressChunk);
+      else {
+        remaining = 0;
+        break;
+      }
+    if (pipeline.isEmpty())
+      return EOF;
+    current = pipeline.popFront();
+    if (!current->ok) {
+      remaining = 0;
+      return EOF;
+    }
+    setg(current->raw.data(), current->raw.data(), current->raw.data() + current->raw.size());
+    return (unsigned char) *gptr();
+  }
+
+  private:
+  shared_ptr<SectionChunk> readChunk() {
+    uint32_t length, compressedLength;
+    if (!readInt(in, length) || !readInt(in, compressedLength) || length > chunkSize ||
+        compressedLength > compressBound(chunkSize))
+      return nullptr;
+    auto ret = make_shared<SectionChunk>();
+    ret->compressed.resize(compressedLength);
+    if (!in.read((char*) ret->compressed.data(), compressedLength))
+      return nullptr;
+    ret->raw.resize(length);
+    remaining -= 2 * sizeof(uint32_t) + compressedLength;
+    return ret;
+  }
+
+  istream& in;
+  long long remaining;
+  shared_ptr<SectionChunk> current;
+  ChunkPipeline pipeline;
+};
+
+SectionedOutput::SectionedOutput(const FilePath& path) : file(path.getPath(), std::ios::binary) {
+  file.write(magic, magicSize);
+}
+
+SectionedOutput::~SectionedOutput() {
+  finish();
+}
+
+ostream& SectionedOutput::beginSection(const string& name) {
+  CHECK(!stream && !finished);
+  index.push_back(SectionInfo{name, (long long) file.tellp(), 0, 0});
+  buffer = make_unique<DeflateStreamBuf>(file);
+  stream = make_unique<ostream>(buffer.get());
+  return *stream;
+}
+
+void SectionedOutput::endSection() {
+  if (!stream->flush())
+    failed = true;
+  index.back().size = buffer->getSize();
+  index.back().rawSize = buffer->getRawSize();
+  INFO << "Section " << index.back().name << ": " << index.back().rawSize << " bytes compressed to "
+      << index.back().size;
+  stream.reset();
+  buffer.reset();
+}
+
+void SectionedOutput::addRawSection(const string& name, const std::vector<shared_ptr<SectionChunk>>& chunks) {
+  beginSection(name);
+  for (auto& chunk : chunks)
+    if (!chunk->raw.empty() && !buffer->addChunk(chunk))
+      failed = true;
+  endSection();
+}
+
+bool SectionedOutput::finish() {
+  if (finished)
+    return !failed;
+  finished = true;
+  if (failed || !file) {
+    failed = true;
+    return false;
+  }
+  long long indexOffset = file.tellp();
+  try {
+    OutputArchive archive(file);
+    archive(index);
+  } catch (::cereal::Exception&) {
+    failed = true;
+    return false;
+  }
+  file.write((const char*) &indexOffset, sizeof(indexOffset));
+  file.write(magic, magicSize);
+  file.close();
+  if (!file)
+    failed = true;
+  return !failed;
+}
+
+struct SectionedBuffer::Section {
+  string name;
+  std::vector<shared_ptr<SectionChunk>> chunks;
+};
+
+SectionedBuffer::SectionedBuffer() {
+}
+
+SectionedBuffer::~SectionedBuffer() {
+}
+
+ostream& SectionedBuffer::beginSection(const string& name) {
+  CHECK(!stream);
+  sections.push_back(make_unique<Section>(Section{name, {}}));
+  buffer = make_unique<ChunkStreamBuf>(sections.back()->chunks);
+  stream = make_unique<ostream>(buffer.get());
+  return *stream;
+}
+
+void SectionedBuffer::endSection() {
+  stream->flush();
+  // Flushing always leaves an unused chunk at the end.
+  sections.back()->chunks.pop_back();
+  stream.reset();
+  buffer.reset();
+}
+
+bool SectionedBuffer::write(const FilePath& path) {
+  SectionedOutput output(path);
+  for (auto& section : sections)
+    output.addRawSection(section->name, section->chunks);
+  return output.finish();
+}
+
+bool SectionedInput::isSectioned(const FilePath& path) {
+  ifstream in(path.getPath(), std::ios::binary);
+  char buf[magicSize];
+  return in.read(buf, magicSize) && std::equal(buf, buf + magicSize, magic);
+}
+
+SectionedInput::SectionedInput(const FilePath& path) : file(path.getPath(), std::ios::binary) {
+  char buf[magicSize];
+  long long indexOffset;
+  if (!file.read(buf, magicSize) || !std::equal(buf, buf + magicSize, magic) ||
+      !file.seekg(-(long long) (sizeof(indexOffset) + magicSize), std::ios::end) ||
+      !file.read((char*) &indexOffset, sizeof(indexOffset)) ||
+      !file.read(buf, magicSize) || !std::equal(buf, buf + magicSize, magic) ||
+      !file.seekg(indexOffset))
+    throw ::cereal::Exception("Not a sectioned file: "_s + path.getPath());
+  InputArchive archive(file);
+  archive(index);
+}
+
+SectionedInput::~SectionedInput() {
+}
+
+bool SectionedInput::hasSection(const string& name) const {
+  for (auto& section : index)
+    if (section.name == name)
+      return true;
+  return false;
+}
+
+istream& SectionedInput::openSection(const string& name) {
+  for (auto& section : index)
+    if (section.name == name) {
+      stream.reset();
+      file.clear();
+      file.seekg(section.offset);
+      buffer = make_unique<InflateStreamBuf>(file, section.size);
+      stream = make_unique<istream>(buffer.get());
+      return *stream;
+    }
+  throw ::cereal::Exception("Missing section: " + name);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "util.h"
+#include "file_path.h"
+
+struct SectionInfo {
+  string SERIAL(name);
+  long long SERIAL(offset);
+  long long SERIAL(size);
+  long long SERIAL(rawSize);
+  SERIALIZE_ALL(name, offset, size, rawSize)
+};
+
+class DeflateStreamBuf;
+class InflateStreamBuf;
+class ChunkStreamBuf;
+struct SectionChunk;
+
+// Save file made of named sections that are compressed independently, followed by an index. Readers can
+// decompress a single section, for example the header when listing saved games, without touching the rest
+// of the file. Each section is a separate archive, so objects can't point into other sections.
+class SectionedOutput {
+  public:
+  SectionedOutput(const FilePath&);
+  ~SectionedOutput();
+  SectionedOutput(const SectionedOutput&) = delete;
+
+  template <typename... Args>
+  void addSection(const string& name, Args&&... args) {
+    {
+      OutputArchive archive(beginSection(name));
+      archive(std::forward<Args>(args)...);
+    }
+    endSection();
+  }
+
+  // Writes the index. Called by the destructor if it wasn't called before. Returns false if any part of the file
+  // couldn't be written.
+  bool finish();
+
+  // Chunks are compressed on a shared pool of this many threads, and the reader decompresses on the same pool.
+  // With one thread everything is done on the calling thread.
+  static void setCompressionThreads(int);
+
+  private:
+  friend class SectionedBuffer;
+  ostream& beginSection(const string& name);
+  void endSection();
+  void addRawSection(const string& name, const std::vector<shared_ptr<SectionChunk>>&);
+  ofstream file;
+  vector<SectionInfo> index;
+  unique_ptr<DeflateStreamBuf> buffer;
+  unique_ptr<ostream> stream;
+  bool finished = false;
+  bool failed = false;
+};
+
+// Sections serialized into memory and not compressed yet. Serializing is the only part of saving that needs the game
+// to stand still, so the rest can be done by write() later, on another thread.
+class SectionedBuffer {
+  public:
+  SectionedBuffer();
+  ~SectionedBuffer();
+  SectionedBuffer(const SectionedBuffer&) = delete;
+
+  template <typename... Args>
+  void addSection(const string& name, Args&&... args) {
+    {
+      OutputArchive archive(beginSection(name));
+      archive(std::forward<Args>(args)...);
+    }
+    endSection();
+  }
+
+  // Compresses the sections and writes them to the file. Returns false if the file couldn't be written.
+  bool write(const FilePath&);
+
+  private:
+  ostream& beginSection(const string& name);
+  void endSection();
+  struct Section;
+  vector<unique_ptr<Section>> sections;
+  unique_ptr<ChunkStreamBuf> buffer;
+  unique_ptr<ostream> stream;
+};
+
+class SectionedInput {
+  public:
+  // Throws cereal::Exception if the file can't be read or isn't a sectioned file.
+  SectionedInput(const FilePath&);
+  ~SectionedInput();
+  SectionedInput(const SectionedInput&) = delete;
+  static bool isSectioned(const FilePath&);
+  bool hasSection(const string& name) const;
+
+  template <typename... Args>
+  void readSection(const string& name, Args&&... args) {
+    InputArchive archive(openSection(name));
+    archive(std::forward<Args>(args)...);
+  }
+
+  private:
+  istream& openSection(const string& name);
+  ifstream file;
+  vector<SectionInfo> index;
+  unique_ptr<InflateStreamBuf> buffer;
+  unique_ptr<istream> stream;
+};
@@ -38,6 +38,7 @@ bool Sectors::contains(Vec2 v) const {
 bool Sectors::add(Vec2 pos) {
   if (contains(pos))
     return false;
+  invalidateCluster(pos);
   set<int> neighbors;
   for (Vec2 v : getNeighbors(pos))
     if (v.inRectangle(bounds) && contains(v))
@@ -148,6 +149,8 @@ vector<Vec2> Sectors::getNeighbors(Vec2 pos) const {
 }
 
 void Sectors::addExtraConnection(Vec2 pos1, Vec2 pos2) {
+  invalidateCluster(pos1);
+  invalidateCluster(pos2);
   if (contains(pos1) && contains(pos2)) {
     auto sector1 = sectors[pos1];
     auto sector2 = sectors[pos2];
@@ -165,6 +168,8 @@ void Sectors::addExtraConnection(Vec2 pos1, Vec2 pos2) {
 }
 
 void Sectors::removeExtraConnection(Vec2 pos1, Vec2 pos2) {
+  invalidateCluster(pos1);
+  invalidateCluster(pos2);
   extraConnections[pos1] = none;
   extraConnections[pos2] = none;
   join(pos1, getNewSector());
@@ -198,6 +203,7 @@ optional<Sectors::SectorId> Sectors::getSector(Vec2 v) const {
 bool Sectors::remove(Vec2 pos) {
   if (!contains(pos))
     return false;
+  invalidateCluster(pos);
   allPos[sectors[pos]].erase(pos);
   sectors[pos] = -1;
   for (Vec2 v : getDisjoint(pos))
@@ -205,6 +211,163 @@ bool Sectors::remove(Vec2 pos) {
   return true;
 }
 
+const int clusterSize = 16;
+// Region ids are cluster index * maxClusterRegions + region index within the cluster.
+const int maxClusterRegions = 256;
+
+int Sectors::getClusterIndex(Vec2 v) const {
+  Vec2 rel = v - bounds.topLeft();
+  int numClustersX = (bounds.width() + clusterSize - 1) / clusterSize;
+  return (rel.y / clusterSize) * numClustersX + rel.x / clusterSize;
+}
+
+Rectangle Sectors::getClusterBounds(int index) const {
+  int numClustersX = (bounds.width() + clusterSize - 1) / clusterSize;
+  Vec2 topLeft = bounds.topLeft() + Vec2(index % numClustersX, index / numClustersX) * clusterSize;
+  return Rectangle(topLeft, topLeft + Vec2(clusterSize, clusterSize)).intersection(bounds);
+}
+
+static int getIndexInCluster(Vec2 v, Rectangle clusterBounds) {
+  v -= clusterBounds.topLeft();
+  return v.y * clusterSize + v.x;
+}
+
+void Sectors::invalidateCluster(Vec2 pos) {
+  auto& clusters = clusterCache.clusters;
+  if (!clusters.empty() && pos.inRectangle(bounds))
+    clusters[getClusterIndex(pos)].dirty = true;
+}
+
+const Sectors::Cluster& Sectors::getCluster(int index) const {
+  auto& clusters = clusterCache.clusters;
+  if (clusters.empty())
+    clusters.resize(getClusterIndex(bounds.bottomRight() - Vec2(1, 1)) + 1);
+  auto& cluster = clusters[index];
+  if (cluster.dirty) {
+    PROFILE_BLOCK("Sectors::buildCluster");
+    Rectangle area = getClusterBounds(index);
+    cluster.labels = vector<short>(clusterSize * clusterSize, -1);
+    cluster.regions.clear();
+    cluster.corridorMark = 0;
+    vector<Vec2> cells;
+    for (Vec2 pos : area)
+      if (contains(pos) && cluster.labels[getIndexInCluster(pos, area)] == -1) {
+        short label = cluster.regions.size();
+        CHECK(label < maxClusterRegions);
+        cells = {pos};
+        cluster.labels[getIndexInCluster(pos, area)] = label;
+        for (int i = 0; i < cells.size(); ++i)
+          for (Vec2 v : getNeighbors(cells[i]))
+            if (v.inRectangle(area) && contains(v) && cluster.labels[getIndexInCluster(v, area)] == -1) {
+              cluster.labels[getIndexInCluster(v, area)] = label;
+              cells.push_back(v);
+            }
+        cluster.regions.emplace_back();
+        auto& region = cluster.regions.back();
+        Vec2 middle = Vec2::getCenterOfWeight(cells);
+        region.center = cells[0];
+        for (Vec2 v : cells) {
+          if (v.dist8(middle) < region.center.dist8(middle))
+            region.center = v;
+          if (v.x == area.left() || v.y == area.top() || v.x == area.right() - 1 || v.y == area.bottom() - 1 ||
+              extraConnections[v])
+            region.borderCells.push_back(v);
+        }
+      }
+    cluster.dirty = false;
+  }
+  return cluster;
+}
+
+optional<int> Sectors::getRegionId(Vec2 v) const {
+  if (!contains(v))
+    return none;
+  int index = getClusterIndex(v);
+  auto label = getCluster(index).labels[getIndexInCluster(v, getClusterBounds(index))];
+  return index * maxClusterRegions + label;
+}
+
+const Sectors::ClusterRegion& Sectors::getRegion(int id) const {
+  return getCluster(id / maxClusterRegions).regions[id % maxClusterRegions];
+}
+
+optional<Sectors::Corridor> Sectors::getCorridor(Vec2 from, Vec2 to, int maxRegions) const {
+  PROFILE;
+  if (!contains(from) || !same(from, to))
+    return none;
+  int startRegion = *getRegionId(from);
+  int targetRegion = *getRegionId(to);
+  // A* over regions. Moving between two regions costs the distance from the center of the first one, through
+  // the pair of adjacent border cells, to the center of the second one.
+  HashMap<int, double> distance {{startRegion, 0}};
+  HashMap<int, int> parent;
+  priority_queue<pair<double, int>, vector<pair<double, int>>, std::greater<pair<double, int>>> q;
+  q.push({from.dist8(to), startRegion});
+  bool found = false;
+  while (!q.empty()) {
+    int id = q.top().second;
+    q.pop();
+    if (id == targetRegion) {
+      found = true;
+      break;
+    }
+    auto& region = getRegion(id);
+    Vec2 center = id == startRegion ? from : region.center;
+    double regionDist = distance.at(id);
+    for (Vec2 border : region.borderCells)
+      for (Vec2 v : getNeighbors(border))
+        if (v.inRectangle(bounds) && contains(v) && getClusterIndex(v) != id / maxClusterRegions) {
+          int nextId = *getRegionId(v);
+          Vec2 nextCenter = nextId == targetRegion ? to : getRegion(nextId).center;
+          double dist = regionDist + center.dist8(border) + 1 + v.dist8(nextCenter);
+          auto it = distance.find(nextId);
+          if (it == distance.end() || it->second > dist) {
+            distance[nextId] = dist;
+            parent[nextId] = id;
+            q.push({dist + nextCenter.dist8(to), nextId});
+          }
+        }
+  }
+  if (!found)
+    return none;
+  vector<int> route {targetRegion};
+  while (route.back() != startRegion)
+    route.push_back(parent.at(route.back()));
+  route = route.reverse();
+  Vec2 target = to;
+  if (route.size() > maxRegions) {
+    route.resize(maxRegions);
+    target = getRegion(route.back()).center;
+  }
+  int mark = ++clusterCache.corridorMark;
+  optional<Rectangle> corridorBounds;
+  for (int id : route) {
+    auto& cluster = clusterCache.clusters[id / maxClusterRegions];
+    cluster.corridorMark = mark;
+    cluster.regions[id % maxClusterRegions].corridorMark = mark;
+    auto clusterBounds = getClusterBounds(id / maxClusterRegions);
+    if (!corridorBounds)
+      corridorBounds = clusterBounds;
+    else
+      corridorBounds = Rectangle(
+          min(corridorBounds->left(), clusterBounds.left()), min(corridorBounds->top(), clusterBounds.top()),
+          max(corridorBounds->right(), clusterBounds.right()), max(corridorBounds->bottom(), clusterBounds.bottom()));
+  }
+  return Corridor{target, *corridorBounds};
+}
+
+bool Sectors::isInCorridor(Vec2 v) const {
+  auto& clusters = clusterCache.clusters;
+  if (clusters.empty() || !contains(v))
+    return false;
+  int index = getClusterIndex(v);
+  auto& cluster = clusters[index];
+  if (cluster.dirty || cluster.corridorMark != clusterCache.corridorMark)
+    return false;
+  auto label = cluster.labels[getIndexInCluster(v, getClusterBounds(index))];
+  return label >= 0 && cluster.regions[label].corridorMark == clusterCache.corridorMark;
+}
+
 void Sectors::dump() {
   for (int i : Range(bounds.height())) {
     for (int j : Range(bounds.width()))
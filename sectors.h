@@ -40,6 +40,17 @@ class Sectors {
   SectorId getLargest() const;
   optional<SectorId> getSector(Vec2) const;
 
+  // Coarse route between two positions of the same sector, planned over connected regions of fixed size clusters.
+  // The regions on the route are marked until the next call, so that a cell-level search can be restricted
+  // to them. If the route goes through more than maxRegions then the returned target is a waypoint in the
+  // last region that was kept.
+  struct Corridor {
+    Vec2 target;
+    Rectangle bounds;
+  };
+  optional<Corridor> getCorridor(Vec2 from, Vec2 to, int maxRegions) const;
+  bool isInCorridor(Vec2) const;
+
   SERIALIZATION_DECL(Sectors)
 
   private:
@@ -48,9 +59,39 @@ class Sectors {
   SectorId getNewSector();
   void join(Vec2, SectorId);
   vector<Vec2> getDisjoint(Vec2) const;
+  struct ClusterRegion {
+    Vec2 center;
+    // Cells on the edge of the cluster or with an extra connection, through which the region is linked to others.
+    vector<Vec2> borderCells;
+    int corridorMark = 0;
+  };
+  struct Cluster {
+    bool dirty = true;
+    vector<short> labels;
+    vector<ClusterRegion> regions;
+    int corridorMark = 0;
+  };
+  // Derived from sectors and rebuilt lazily, so it's neither serialized nor copied.
+  struct ClusterCache {
+    ClusterCache() {}
+    ClusterCache(const ClusterCache&) {}
+    ClusterCache& operator = (const ClusterCache&) {
+      clusters.clear();
+      return *this;
+    }
+    vector<Cluster> clusters;
+    int corridorMark = 0;
+  };
+  int getClusterIndex(Vec2) const;
+  Rectangle getClusterBounds(int index) const;
+  const Cluster& getCluster(int index) const;
+  optional<int> getRegionId(Vec2) const;
+  const ClusterRegion& getRegion(int id) const;
+  void invalidateCluster(Vec2);
   Rectangle SERIAL(bounds);
   Table<SectorId> SERIAL(sectors);
   vector<PosSet> SERIAL(allPos);
   ExtraConnections SERIAL(extraConnections);
+  mutable ClusterCache clusterCache;
 };
 
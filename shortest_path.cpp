@@ -21,6 +21,7 @@
 #include "lasting_effect.h"
 #include "furniture.h"
 #include "furniture_usage.h"
+#include "sim_benchmark.h"
 
 SERIALIZE_DEF(ShortestPath, path, target, bounds, reversed)
 SERIALIZATION_CONSTRUCTOR_IMPL(ShortestPath)
@@ -53,17 +54,129 @@ class DistanceTable {
   int counter = 1;
 };
 
-static DistanceTable distanceTable(Level::getMaxBounds());
-static DirtyTable<double> navigationCostCache(Level::getMaxBounds(), 0);
+// Priority queue for non-negative keys, which are quantized into buckets. Each bucket is a small heap, so elements
+// are popped in the exact order of their keys, with ties broken by position like in the regular heap. Keys beyond
+// the last bucket go to a regular heap, which is only used once all buckets are empty.
+class BucketQueue {
+  public:
+  void push(Vec2 pos, double value) {
+    int index = max(0, int(value * bucketsPerUnit));
+    if (index >= maxBuckets) {
+      overflow.push(QueueElem{pos, value});
+      return;
+    }
+    if (index >= buckets.size())
+      buckets.resize(index + 1);
+    auto& bucket = buckets[index];
+    bucket.push_back(QueueElem{pos, value});
+    std::push_heap(bucket.begin(), bucket.end());
+    current = min(current, index);
+    maxUsed = max(maxUsed, index);
+    ++numElems;
+  }
+
+  bool empty() const {
+    return numElems == 0 && overflow.empty();
+  }
+
+  Vec2 top() {
+    if (numElems == 0)
+      return overflow.top().pos;
+    while (buckets[current].empty())
+      ++current;
+    return buckets[current].front().pos;
+  }
+
+  void pop() {
+    if (numElems == 0)
+      overflow.pop();
+    else {
+      top();
+      auto& bucket = buckets[current];
+      std::pop_heap(bucket.begin(), bucket.end());
+      bucket.pop_back();
+      --numElems;
+    }
+  }
+
+  void clear() {
+    for (int i = current; i <= maxUsed && i < buckets.size(); ++i)
+      buckets[i].clear();
+    current = maxBuckets;
+    maxUsed = 0;
+    numElems = 0;
+    overflow = decltype(overflow)();
+  }
+
+  private:
+  static constexpr int bucketsPerUnit = 4;
+  static constexpr int maxBuckets = 1 << 15;
+  struct QueueElem {
+    Vec2 pos;
+    double value;
+    bool operator < (const QueueElem& o) const {
+      return value > o.value || (value == o.value && pos < o.pos);
+    }
+  };
+  vector<vector<QueueElem>> buckets;
+  priority_queue<QueueElem> overflow;
+  int current = maxBuckets;
+  int maxUsed = 0;
+  int numElems = 0;
+};
+
+// Dense tables used by a single search. They are pooled per thread and stamped with a generation,
+// so that starting a search doesn't touch the whole table and nested searches don't interfere.
+struct PathSearchTables {
+  DistanceTable distance { Level::getMaxBounds() };
+  DirtyTable<double> entryCost { Level::getMaxBounds(), 0 };
+  // Squares whose distance is final. Only used by Dijkstra.
+  DirtyTable<bool> closed { Level::getMaxBounds(), false };
+  BucketQueue queue;
+};
+
+class PooledSearchTables {
+  public:
+  PooledSearchTables() {
+    if (freeTables.empty())
+      tables = make_unique<PathSearchTables>();
+    else {
+      tables = std::move(freeTables.back());
+      freeTables.pop_back();
+    }
+    tables->distance.clear();
+    tables->entryCost.clear();
+    tables->closed.clear();
+    tables->queue.clear();
+  }
+
+  ~PooledSearchTables() {
+    freeTables.push_back(std::move(tables));
+  }
+
+  PathSearchTables& operator * () {
+    return *tables;
+  }
+
+  PathSearchTables* operator -> () {
+    return tables.get();
+  }
+
+  private:
+  unique_ptr<PathSearchTables> tables;
+  static thread_local vector<unique_ptr<PathSearchTables>> freeTables;
+};
+
+thread_local vector<unique_ptr<PathSearchTables>> PooledSearchTables::freeTables;
 
 template <typename Fun>
-static auto getCached(Fun fun) {
-  return [fun] (Vec2 v) {
-    if (navigationCostCache.isDirty(v))
-      return navigationCostCache.getDirtyValue(v);
+static auto getCached(Fun& fun, DirtyTable<double>& cache) {
+  return [&fun, &cache] (Vec2 v) {
+    if (cache.isDirty(v))
+      return cache.getDirtyValue(v);
     else {
-      auto res = fun(v);
-      navigationCostCache.setValue(v, res);
+      double res = fun(v);
+      cache.setValue(v, res);
       return res;
     }
   };
@@ -71,6 +184,14 @@ static auto getCached(Fun fun) {
 
 const int margin = 15;
 
+// Paths longer than this are first planned over Sectors clusters, and the cell search is only run
+// along the resulting corridor, up to a limited number of regions at a time.
+const int hierarchicalPathMinDistance = 32;
+const int maxCorridorRegions = 12;
+
+// Shorter paths are cheap enough to not bother with flow fields.
+const int flowFieldMinDistance = 10;
+
 ShortestPath::ShortestPath(Rectangle a, function<double(Vec2)> entryFun, function<double(Vec2)> lengthFun,
     function<vector<Vec2>(Vec2)> directions, Vec2 to, Vec2 from, double mult) : ShortestPath(TemplateConstr{},
     std::move(a), std::move(entryFun), std::move(lengthFun), std::move(directions), to, from, mult) {}
@@ -80,74 +201,65 @@ ShortestPath::ShortestPath(TemplateConstr, Rectangle a, EntryFun entryFun, Lengt
     DirectionsFun directions, Vec2 to, Vec2 from, double mult) : target(to), bounds(a) {
   PROFILE;
   CHECK(Level::getMaxBounds().contains(a));
-  navigationCostCache.clear();
+  PooledSearchTables tables;
   if (mult == 0)
-    init(getCached(entryFun), lengthFun, directions, target, from);
+    init(*tables, getCached(entryFun, tables->entryCost), lengthFun, directions, target, from);
   else {
-    init(getCached(entryFun), lengthFun, directions, target, none, revShortestLimit);
-    distanceTable.setDistance(target, infinity);
-    navigationCostCache.clear();
-    reverse(getCached(entryFun), lengthFun, directions, mult, from);
+    init(*tables, getCached(entryFun, tables->entryCost), lengthFun, directions, target, none, revShortestLimit);
+    tables->distance.setDistance(target, infinity);
+    tables->entryCost.clear();
+    reverse(*tables, getCached(entryFun, tables->entryCost), lengthFun, directions, mult, from);
   }
 }
 
-ShortestPath::ShortestPath(Rectangle area, function<double (Vec2)> entryFun, function<double(Vec2)> lengthFun,
-    vector<Vec2> directions, Vec2 target, Vec2 from, double mult) : ShortestPath(area, entryFun, lengthFun,
-    [directions](Vec2) { return directions; }, target, from, mult)
-{
+ShortestPath::ShortestPath(const Table<double>& entryCost, Vec2 target, Vec2 from)
+    : ShortestPath(TemplateConstr{}, entryCost.getBounds(),
+        [&entryCost](Vec2 v) { return entryCost[v]; },
+        [from](Vec2 v) -> double { return from.dist8(v); },
+        [](Vec2) -> const vector<Vec2>& { return Vec2::directions8(); }, target, from) {
 }
 
-struct QueueElem {
-  Vec2 pos;
-  double value;
-};
-
-bool inline operator < (const QueueElem& e1, const QueueElem& e2) {
-  return e1.value > e2.value || (e1.value == e2.value && e1.pos < e2.pos);
+ShortestPath::ShortestPath(Rectangle area, function<double (Vec2)> entryFun, function<double(Vec2)> lengthFun,
+    vector<Vec2> directions, Vec2 target, Vec2 from, double mult) : ShortestPath(TemplateConstr{}, area,
+    std::move(entryFun), std::move(lengthFun),
+    [directions = std::move(directions)](Vec2) -> const vector<Vec2>& { return directions; }, target, from, mult)
+{
 }
 
 template <typename EntryFun, typename LengthFun, typename DirectionsFun>
-void ShortestPath::init(EntryFun entryFun, LengthFun lengthFun, DirectionsFun directions,
+void ShortestPath::init(PathSearchTables& tables, EntryFun entryFun, LengthFun lengthFun, DirectionsFun directions,
     Vec2 target, optional<Vec2> from, optional<int> limit) {
   PROFILE;
   reversed = false;
-  distanceTable.clear();
-  function<QueueElem(Vec2)> makeElem;
-  if (from)
-    makeElem = [&](Vec2 pos) ->QueueElem { return {pos, distanceTable.getDistance(pos) + lengthFun(pos)}; };
-  else
-    makeElem = [&](Vec2 pos) ->QueueElem { return {pos, distanceTable.getDistance(pos)}; };
-  priority_queue<QueueElem, vector<QueueElem>> q;
+  auto& distanceTable = tables.distance;
+  auto& q = tables.queue;
+  auto getValue = [&](Vec2 pos) {
+    return from ? distanceTable.getDistance(pos) + lengthFun(pos) : distanceTable.getDistance(pos);
+  };
   distanceTable.setDistance(target, 0);
-  q.push(makeElem(target));
+  q.push(target, getValue(target));
   int numPopped = 0;
   while (!q.empty()) {
     ++numPopped;
-    Vec2 pos = q.top().pos;
+    Vec2 pos = q.top();
     double posDist = distanceTable.getDistance(pos);
-   // INFO << "Popping " << pos << " " << distance[pos]  << " " << (from ? (*from - pos).length4() : 0);
-    if (from == pos || (limit && distanceTable.getDistance(pos) >= *limit)) {
+    if (from == pos || (limit && posDist >= *limit)) {
       INFO << "Shortest path from " << (from ? *from : Vec2(-1, -1)) << " to " << target << " " << numPopped
-        << " visited distance " << distanceTable.getDistance(pos);
-      constructPath(pos, directions);
+        << " visited distance " << posDist;
+      constructPath(tables, pos, directions);
       return;
     }
     q.pop();
     for (Vec2 dir : directions(pos)) {
-      PROFILE_BLOCK("loop body");
       Vec2 next = pos + dir;
       if (next.inRectangle(bounds)) {
         double nextDist = distanceTable.getDistance(next);
         if (posDist < nextDist) {
-          PROFILE_BLOCK("check entry");
           double dist = posDist + entryFun(next);
           CHECK(dist > posDist) << "Entry fun non positive " << dist - posDist;
           if (dist < nextDist) {
             distanceTable.setDistance(next, dist);
-            {
-              PROFILE_BLOCK("queue push");
-              q.push(makeElem(next));
-            }
+            q.push(next, getValue(next));
           }
         }
       }
@@ -156,10 +268,22 @@ void ShortestPath::init(EntryFun entryFun, LengthFun lengthFun, DirectionsFun di
   INFO << "Shortest path exhausted, " << numPopped << " visited";
 }
 
-void ShortestPath::reverse(function<double(Vec2)> entryFun, function<double(Vec2)> lengthFun, function<vector<Vec2>(Vec2)> directions,
-    double mult, Vec2 from) {
+struct QueueElem {
+  Vec2 pos;
+  double value;
+};
+
+bool inline operator < (const QueueElem& e1, const QueueElem& e2) {
+  return e1.value > e2.value || (e1.value == e2.value && e1.pos < e2.pos);
+}
+
+template <typename EntryFun, typename LengthFun, typename DirectionsFun>
+void ShortestPath::reverse(PathSearchTables& tables, EntryFun entryFun, LengthFun lengthFun,
+    DirectionsFun directions, double mult, Vec2 from) {
   PROFILE;
   reversed = true;
+  auto& distanceTable = tables.distance;
+  // Distances are negative here, so this can't use the bucket queue.
   auto makeElem = [&](Vec2 pos)->QueueElem { return {pos, distanceTable.getDistance(pos) + lengthFun(pos)};};
   priority_queue<QueueElem, vector<QueueElem>> q;
   for (Vec2 v : bounds) {
@@ -175,7 +299,7 @@ void ShortestPath::reverse(function<double(Vec2)> entryFun, function<double(Vec2
     Vec2 pos = q.top().pos;
     if (from == pos) {
       INFO << "Rev shortest path from " << " from " << target << " " << numPopped << " visited";
-      constructPath(pos, directions, true);
+      constructPath(tables, pos, directions, true);
       return;
     }
     q.pop();
@@ -191,7 +315,9 @@ void ShortestPath::reverse(function<double(Vec2)> entryFun, function<double(Vec2
   INFO << "Rev shortest path from " << " from " << target << " " << numPopped << " visited";
 }
 
-void ShortestPath::constructPath(Vec2 pos, function<vector<Vec2>(Vec2)> directions, bool reversed) {
+template <typename DirectionsFun>
+void ShortestPath::constructPath(PathSearchTables& tables, Vec2 pos, DirectionsFun directions, bool reversed) {
+  auto& distanceTable = tables.distance;
   vector<Vec2> ret;
   auto origPos = pos;
   while (pos != target) {
@@ -220,6 +346,11 @@ void ShortestPath::constructPath(Vec2 pos, function<vector<Vec2>(Vec2)> directio
   path = ret.reverse();
 }
 
+ShortestPath::ShortestPath(Rectangle area, vector<Vec2> p) : path(std::move(p)), bounds(area), reversed(false) {
+  CHECK(!path.empty());
+  target = path[0];
+}
+
 bool ShortestPath::isReversed() const {
   return reversed;
 }
@@ -253,8 +384,33 @@ Vec2 ShortestPath::getTarget() const {
   return target;
 }
 
+static optional<Vec2> getPortalDirection(Level* level, Vec2 v) {
+  Position pos(v, level);
+  if (auto f = pos.getFurniture(FurnitureLayer::MIDDLE))
+    if (f->hasUsageType(BuiltinUsageId::PORTAL))
+      if (auto otherPos = pos.getOtherPortal())
+        if (otherPos->isSameLevel(pos))
+          if (auto f2 = otherPos->getFurniture(FurnitureLayer::MIDDLE))
+            if (f2->hasUsageType(BuiltinUsageId::PORTAL))
+              return otherPos->getCoord() - v;
+  return none;
+}
+
+// Avoids allocating for every visited square. The returned reference is only valid until the buffer is reused.
+static const vector<Vec2>& getDirections(Level* level, Vec2 v, vector<Vec2>& buffer) {
+  if (!level)
+    return Vec2::directions8();
+  if (auto portalDir = getPortalDirection(level, v)) {
+    buffer = Vec2::directions8();
+    buffer.push_back(*portalDir);
+    return buffer;
+  }
+  return Vec2::directions8();
+}
+
 ShortestPath LevelShortestPath::makeShortestPath(Position from, MovementType movementType, Position to, double mult) {
   PROFILE;
+  BENCHMARK_PHASE(PATHFINDING);
   Level* level = from.getLevel();
   Rectangle bounds = level->getBounds();
   CHECK(to.isSameLevel(from));
@@ -268,21 +424,15 @@ ShortestPath LevelShortestPath::makeShortestPath(Position from, MovementType mov
       return ShortestPath::infinity;
     return Position(v, level, Position::IsValid{}).getNavigationCost(movementType, movementSectors);
   };
-  auto directionsFun = [=] (Vec2 v) {
-    Position pos(v, level);
-    vector<Vec2> ret = Vec2::directions8();
-    if (auto f = pos.getFurniture(FurnitureLayer::MIDDLE))
-      if (f->hasUsageType(BuiltinUsageId::PORTAL))
-        if (auto otherPos = pos.getOtherPortal())
-          if (otherPos->isSameLevel(pos))
-            if (auto f2 = otherPos->getFurniture(FurnitureLayer::MIDDLE))
-              if (f2->hasUsageType(BuiltinUsageId::PORTAL))
-                ret.push_back(otherPos->getCoord() - v);
-    return ret;
+  auto directionsFun = [level, buffer = vector<Vec2>()] (Vec2 v) mutable -> const vector<Vec2>& {
+    return getDirections(level, v, buffer);
   };
   CHECK(to.getCoord().inRectangle(level->getBounds()));
   CHECK(from.getCoord().inRectangle(level->getBounds()));
   if (mult == 0) {
+    if (from.getCoord().dist8(to.getCoord()) > flowFieldMinDistance)
+      if (auto path = level->getFlowFields().getPath(level, movementType, from.getCoord(), to.getCoord()))
+        return std::move(*path);
     auto dist1 = from.getDistanceToNearestPortal().value_or(10000);
     auto lengthFun = [level, from = from.getCoord(), dist1](Vec2 to) {
       PROFILE_BLOCK("length fun");
@@ -290,6 +440,16 @@ ShortestPath LevelShortestPath::makeShortestPath(Position from, MovementType mov
       // Use a suboptimal, but faster pathfinding.
       return 2 * min<double>(from.dist8(to) + 0.01 * from.distD(to), dist1 + dist2);
     };
+    if (from.getCoord().dist8(to.getCoord()) > hierarchicalPathMinDistance)
+      if (auto corridor = sectors.getCorridor(from.getCoord(), to.getCoord(), maxCorridorRegions)) {
+        auto corridorEntryFun = [&sectors, &entryFun](Vec2 v) {
+          return sectors.isInCorridor(v) ? entryFun(v) : ShortestPath::infinity;
+        };
+        auto path = ShortestPath(ShortestPath::TemplateConstr{}, corridor->bounds, corridorEntryFun, lengthFun,
+            directionsFun, corridor->target, from.getCoord(), mult);
+        if (!path.getPath().empty())
+          return path;
+      }
     return ShortestPath(ShortestPath::TemplateConstr{}, bounds, entryFun, lengthFun, directionsFun, to.getCoord(), from.getCoord(), mult);
   } else {
     auto lengthFun = [from = from.getCoord()](Vec2 to)->double { return from.dist8(to); };
@@ -301,7 +461,7 @@ ShortestPath LevelShortestPath::makeShortestPath(Position from, MovementType mov
   }
 }
 
-SERIALIZE_DEF(LevelShortestPath, path, level)
+SERIALIZE_DEF(LevelShortestPath, path, level, finalTarget, movementType)
 SERIALIZATION_CONSTRUCTOR_IMPL(LevelShortestPath);
 
 
@@ -310,6 +470,10 @@ LevelShortestPath::LevelShortestPath(const Creature* creature, Position target,
 
 LevelShortestPath::LevelShortestPath(Position from, MovementType type, Position to, double mult)
     : path(makeShortestPath(from, type, to, mult)), level(to.getLevel()) {
+  if (path.getTarget() != to.getCoord()) {
+    finalTarget = to.getCoord();
+    movementType = type;
+  }
 }
 
 Level* LevelShortestPath::getLevel() const {
@@ -317,7 +481,18 @@ Level* LevelShortestPath::getLevel() const {
 }
 
 vector<Position> LevelShortestPath::getPath() const {
-  return path.getPath().transform([this](Vec2 v) { return Position(v, level); });
+  auto ret = path.getPath().transform([this](Vec2 v) { return Position(v, level); });
+  if (finalTarget && movementType && !ret.empty()) {
+    // Only the path to the waypoint is known, so the rest is planned here to show the whole path. Moves only
+    // shorten the path at the start, so the waypoint and the rest of the path don't change.
+    if (!restOfPath) {
+      restOfPath = LevelShortestPath(ret[0], *movementType, Position(*finalTarget, level)).getPath();
+      if (!restOfPath->empty())
+        restOfPath->pop_back();
+    }
+    ret = concat(*restOfPath, std::move(ret));
+  }
+  return ret;
 }
 
 bool LevelShortestPath::isReachable(Position pos) const {
@@ -340,91 +515,252 @@ optional<Position> LevelShortestPath::getNextNextMove(Position pos) {
 }
 
 Position LevelShortestPath::getTarget() const {
-  return Position(path.getTarget(), level);
+  return Position(finalTarget.value_or(path.getTarget()), level);
 }
 
 bool LevelShortestPath::isReversed() const {
   return path.isReversed();
 }
 
+FlowField::FlowField(Level* level, const MovementType& type, Vec2 target) : movementType(type), target(target),
+    distance(level->getBounds(), ShortestPath::infinity), entryCost(level->getBounds(), ShortestPath::infinity) {
+  PROFILE;
+  auto& sectors = level->getSectors(movementType);
+  for (Vec2 v : level->getBounds())
+    if (sectors.contains(v))
+      entryCost[v] = getEntryCost(level, v);
+  distance[target] = 0;
+  propagate(level, {target});
+}
+
+FlowField::FlowField(Table<float> entryCostTable, Vec2 target) : target(target),
+    distance(entryCostTable.getBounds(), ShortestPath::infinity), entryCost(std::move(entryCostTable)) {
+  distance[target] = 0;
+  propagate(nullptr, {target});
+}
+
+int FlowField::getMemoryUsage() const {
+  return (distance.getWidth() * distance.getHeight() + entryCost.getWidth() * entryCost.getHeight()) * sizeof(float);
+}
+
+float FlowField::getEntryCost(Level* level, Vec2 v) const {
+  if (!level->getSectors(movementType).contains(v))
+    return ShortestPath::infinity;
+  auto& movementSectors = level->getSectors(copyOf(movementType).setCanBuildBridge(false).setDestroyActions({}));
+  // Squares occupied by creatures aren't any more expensive here, since the field is shared.
+  if (movementSectors.contains(v))
+    return 1.0;
+  return Position(v, level, Position::IsValid{}).getNavigationCost(movementType, movementSectors);
+}
+
+void FlowField::propagate(Level* level, vector<Vec2> from) {
+  vector<Vec2> directionsBuffer;
+  priority_queue<pair<float, Vec2>, vector<pair<float, Vec2>>, std::greater<pair<float, Vec2>>> q;
+  for (Vec2 v : from)
+    q.push({distance[v], v});
+  while (!q.empty()) {
+    auto elem = q.top();
+    q.pop();
+    Vec2 pos = elem.second;
+    if (elem.first > distance[pos])
+      continue;
+    for (Vec2 dir : getDirections(level, pos, directionsBuffer)) {
+      Vec2 next = pos + dir;
+      if (next.inRectangle(distance.getBounds()) && entryCost[next] < ShortestPath::infinity) {
+        float dist = distance[pos] + entryCost[next];
+        if (dist < distance[next]) {
+          distance[next] = dist;
+          q.push({dist, next});
+        }
+      }
+    }
+  }
+}
+
+bool FlowField::update(Level* level, const HashSet<Vec2>& changed) {
+  PROFILE;
+  vector<Vec2> directionsBuffer;
+  vector<Vec2> improved;
+  for (Vec2 v : changed) {
+    float cost = getEntryCost(level, v);
+    if (cost > entryCost[v] && distance[v] < ShortestPath::infinity && v != target)
+      return false;
+    if (cost < entryCost[v] && v != target) {
+      entryCost[v] = cost;
+      for (Vec2 dir : getDirections(level, v, directionsBuffer)) {
+        Vec2 neighbor = v + dir;
+        if (neighbor.inRectangle(distance.getBounds()))
+          distance[v] = min(distance[v], distance[neighbor] + cost);
+      }
+      if (distance[v] < ShortestPath::infinity)
+        improved.push_back(v);
+    } else
+      entryCost[v] = cost;
+  }
+  propagate(level, std::move(improved));
+  return true;
+}
+
+optional<vector<Vec2>> FlowField::getPath(Level* level, Vec2 from) const {
+  PROFILE;
+  vector<Vec2> directionsBuffer;
+  vector<Vec2> ret {from};
+  Vec2 pos = from;
+  while (pos != target) {
+    optional<Vec2> best;
+    float bestValue = ShortestPath::infinity;
+    for (Vec2 dir : getDirections(level, pos, directionsBuffer)) {
+      Vec2 next = pos + dir;
+      if (next.inRectangle(distance.getBounds()) && distance[next] < distance[pos]) {
+        // Steer around creatures where it doesn't make the path longer by much.
+        float value = distance[next];
+        if (level && next != target && Position(next, level, Position::IsValid{}).getCreature())
+          value += 4;
+        if (value < bestValue) {
+          bestValue = value;
+          best = next;
+        }
+      }
+    }
+    if (!best)
+      return none;
+    pos = *best;
+    ret.push_back(pos);
+  }
+  return ret.reverse();
+}
+
+// Number of requests for the same target after which a flow field is built for it.
+const int flowFieldMinRequests = 3;
+const int maxFlowFieldEntries = 16;
+// Total size of the fields of a level. The least recently used fields are dropped above it.
+const int maxFlowFieldBytes = 16 << 20;
+// If that many squares changed since the last request the field is rebuilt instead of updated.
+const int maxFlowFieldChanges = 200;
+
+optional<ShortestPath> FlowFieldCache::getPath(Level* level, const MovementType& movementType, Vec2 from,
+    Vec2 target) {
+  PROFILE;
+  optional<int> index;
+  for (int i : All(entries))
+    if (entries[i].target == target && entries[i].movementType == movementType) {
+      index = i;
+      break;
+    }
+  if (!index) {
+    if (entries.size() >= maxFlowFieldEntries)
+      entries.removeIndexPreserveOrder(0);
+    entries.push_back(Entry{target, movementType, 0, nullptr, {}});
+    index = entries.size() - 1;
+  }
+  // Keep the most recently used entries at the back.
+  auto entry = entries.removeIndexPreserveOrder(*index);
+  ++entry.numRequests;
+  if (entry.field && !entry.changed.empty()) {
+    if (entry.changed.size() > maxFlowFieldChanges || !entry.field->update(level, entry.changed))
+      entry.field = nullptr;
+    entry.changed.clear();
+  }
+  if (!entry.field && entry.numRequests >= flowFieldMinRequests) {
+    entry.field = make_unique<FlowField>(level, movementType, target);
+    int totalBytes = entry.field->getMemoryUsage();
+    for (auto& elem : entries)
+      if (elem.field)
+        totalBytes += elem.field->getMemoryUsage();
+    for (auto& elem : entries)
+      if (elem.field && totalBytes > maxFlowFieldBytes) {
+        totalBytes -= elem.field->getMemoryUsage();
+        elem.field = nullptr;
+      }
+  }
+  optional<vector<Vec2>> path;
+  if (entry.field)
+    path = entry.field->getPath(level, from);
+  entries.push_back(std::move(entry));
+  if (path && path->size() >= 2)
+    return ShortestPath(level->getBounds(), std::move(*path));
+  return none;
+}
+
+void FlowFieldCache::squareChanged(Vec2 pos) {
+  for (auto& entry : entries)
+    if (entry.field)
+      entry.changed.insert(pos);
+}
+
+void FlowFieldCache::clear() {
+  entries.clear();
+}
+
 Dijkstra::Dijkstra(Rectangle bounds, vector<Vec2> from, int maxDist, function<double(Vec2)> entryFun,
-      vector<Vec2> directions) {
-  distanceTable.clear();
-  auto comparator = [](Vec2 pos1, Vec2 pos2) {
-      double diff = distanceTable.getDistance(pos1) - distanceTable.getDistance(pos2);
-      if (diff > 0 || (diff == 0 && pos1 < pos2))
-        return 1;
-      else
-        return 0;};
-  priority_queue<Vec2, vector<Vec2>, decltype(comparator)> q(comparator) ;
+      vector<Vec2> directions) : distance(bounds, ShortestPath::infinity) {
+  PooledSearchTables tables;
+  auto& q = tables->queue;
   for (auto& v : from) {
-    distanceTable.setDistance(v, 0);
-    q.push(v);
+    distance[v] = 0;
+    q.push(v, 0);
   }
   while (!q.empty()) {
     Vec2 pos = q.top();
-    double cdist = distanceTable.getDistance(pos);
+    q.pop();
+    // Elements can be queued multiple times, only the first one popped has the final distance.
+    if (tables->closed.isDirty(pos))
+      continue;
+    double cdist = distance[pos];
     if (cdist > maxDist)
       return;
-    q.pop();
-    CHECK(!reachable.count(pos));
-    reachable[pos] = cdist;
+    tables->closed.setValue(pos, true);
+    reachable.push_back(pos);
     for (Vec2 dir : directions) {
       Vec2 next = pos + dir;
       if (next.inRectangle(bounds)) {
-        double ndist = distanceTable.getDistance(next);
+        double ndist = distance[next];
         if (cdist < ndist) {
           double dist = cdist + entryFun(next);
           CHECK(dist > cdist) << "Entry fun non positive " << dist - cdist;
           if (dist < ndist && dist <= maxDist) {
-            distanceTable.setDistance(next, dist);
-            q.push(next);
+            distance[next] = dist;
+            q.push(next, dist);
           }
         }
       }
     }
   }
-
 }
 
 bool Dijkstra::isReachable(Vec2 pos) const {
-  return reachable.count(pos);
+  return pos.inRectangle(distance.getBounds()) && distance[pos] < ShortestPath::infinity;
 }
 
 double Dijkstra::getDist(Vec2 v) const {
-  return reachable.at(v);
+  CHECK(isReachable(v));
+  return distance[v];
 }
 
-const Dijkstra::DistanceMap& Dijkstra::getAllReachable() const {
+const vector<Vec2>& Dijkstra::getAllReachable() const {
   return reachable;
 }
 
-BfSearch::BfSearch(Rectangle bounds, Vec2 from, function<bool(Vec2)> entryFun, vector<Vec2> directions) {
-  distanceTable.clear();
-  queue<Vec2> q;
-  distanceTable.setDistance(from, 0);
-  q.push(from);
-  while (!q.empty()) {
-    Vec2 pos = q.front();
-    q.pop();
-    CHECK(!reachable.count(pos));
-    reachable.insert(pos);
+BfSearch::BfSearch(Rectangle bounds, Vec2 from, function<bool(Vec2)> entryFun, vector<Vec2> directions)
+    : visited(bounds, false) {
+  visited[from] = true;
+  reachable.push_back(from);
+  for (int i = 0; i < reachable.size(); ++i) {
+    Vec2 pos = reachable[i];
     for (Vec2 dir : directions) {
       Vec2 next = pos + dir;
-      if (next.inRectangle(bounds) && distanceTable.getDistance(next) == ShortestPath::infinity && entryFun(next)) {
-        distanceTable.setDistance(next, 0);
-        q.push(next);
+      if (next.inRectangle(bounds) && !visited[next] && entryFun(next)) {
+        visited[next] = true;
+        reachable.push_back(next);
       }
     }
   }
-
 }
 
 bool BfSearch::isReachable(Vec2 pos) const {
-  return reachable.count(pos);
+  return pos.inRectangle(visited.getBounds()) && visited[pos];
 }
 
-const BfSearch::ReachableSet& BfSearch::getAllReachable() const {
+const vector<Vec2>& BfSearch::getAllReachable() const {
   return reachable;
 }
-
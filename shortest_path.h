@@ -19,9 +19,11 @@
 
 #include "util.h"
 #include "position.h"
+#include "movement_type.h"
 
 class Creature;
 class Level;
+struct PathSearchTables;
 
 class ShortestPath {
   public:
@@ -47,6 +49,11 @@ class ShortestPath {
       Vec2 target,
       Vec2 from,
       double mult = 0);
+  // Searches a table of entry costs in 8 directions. Unlike the constructors that take std::functions, the cost
+  // and distance lookups are inlined into the search.
+  ShortestPath(const Table<double>& entryCost, Vec2 target, Vec2 from);
+  // Wraps an already computed path, ordered from the target to the starting position.
+  ShortestPath(Rectangle area, vector<Vec2> path);
   bool isReachable(Vec2 pos) const;
   Vec2 getNextMove(Vec2 pos);
   optional<Vec2> getNextNextMove(Vec2 pos);
@@ -60,11 +67,13 @@ class ShortestPath {
 
   private:
   template <typename EntryFun, typename LengthFun, typename DirectionsFun>
-  void init(EntryFun entryFun, LengthFun lengthFun, DirectionsFun directions,
+  void init(PathSearchTables&, EntryFun entryFun, LengthFun lengthFun, DirectionsFun directions,
       Vec2 target, optional<Vec2> from, optional<int> limit = none);
-  void reverse(function<double(Vec2)> entryFun, function<double(Vec2)> lengthFun,
-      function<vector<Vec2>(Vec2)> directions, double mult, Vec2 from);
-  void constructPath(Vec2 start, function<vector<Vec2>(Vec2)> directions, bool reversed = false);
+  template <typename EntryFun, typename LengthFun, typename DirectionsFun>
+  void reverse(PathSearchTables&, EntryFun entryFun, LengthFun lengthFun, DirectionsFun directions, double mult,
+      Vec2 from);
+  template <typename DirectionsFun>
+  void constructPath(PathSearchTables&, Vec2 start, DirectionsFun directions, bool reversed = false);
   vector<Vec2> SERIAL(path);
   Vec2 SERIAL(target);
   Rectangle SERIAL(bounds);
@@ -91,6 +100,54 @@ class LevelShortestPath {
   static ShortestPath makeShortestPath(Position, MovementType, Position to, double mult);
   ShortestPath SERIAL(path);
   Level* SERIAL(level) = nullptr;
+  // Set if the path only leads to a waypoint on the way to the real target.
+  optional<Vec2> SERIAL(finalTarget);
+  optional<MovementType> SERIAL(movementType);
+  // Path from the waypoint to the final target, planned on the first call to getPath().
+  mutable optional<vector<Position>> restOfPath;
+};
+
+// Distances from all squares of a level to a single target, so that paths of many creatures heading to
+// the same place can be read off it without running a search for each one. The distances ignore other creatures.
+class FlowField {
+  public:
+  FlowField(Level*, const MovementType&, Vec2 target);
+  // Field over the given entry costs, without a level. Squares are only connected to their 8 neighbors.
+  FlowField(Table<float> entryCost, Vec2 target);
+  // Applies squares that changed since the field was built. Squares that became cheaper are propagated,
+  // returns false if a reachable square became more expensive and the field needs to be rebuilt.
+  bool update(Level*, const HashSet<Vec2>& changed);
+  // The level may be null for fields built without one.
+  optional<vector<Vec2>> getPath(Level*, Vec2 from) const;
+  int getMemoryUsage() const;
+
+  private:
+  float getEntryCost(Level*, Vec2) const;
+  void propagate(Level*, vector<Vec2> from);
+  MovementType movementType;
+  Vec2 target;
+  // Distances are sums of small entry costs, so floats are precise enough and take half the memory.
+  Table<float> distance;
+  Table<float> entryCost;
+};
+
+class FlowFieldCache {
+  public:
+  // Returns a path read off a shared flow field. A field is only built once the same target has been
+  // requested a few times, until then none is returned and the caller should run a regular search.
+  optional<ShortestPath> getPath(Level*, const MovementType&, Vec2 from, Vec2 target);
+  void squareChanged(Vec2);
+  void clear();
+
+  private:
+  struct Entry {
+    Vec2 target;
+    MovementType movementType;
+    int numRequests;
+    unique_ptr<FlowField> field;
+    HashSet<Vec2> changed;
+  };
+  vector<Entry> entries;
 };
 
 class Dijkstra {
@@ -99,21 +156,21 @@ class Dijkstra {
       vector<Vec2> directions = Vec2::directions8());
   bool isReachable(Vec2) const;
   double getDist(Vec2) const;
-  using DistanceMap = HashMap<Vec2, double>;
-  const DistanceMap& getAllReachable() const;
+  // Reachable positions in the order in which they were visited.
+  const vector<Vec2>& getAllReachable() const;
 
   private:
-  DistanceMap reachable;
+  Table<double> distance;
+  vector<Vec2> reachable;
 };
 
 class BfSearch {
   public:
   BfSearch(Rectangle bounds, Vec2 from, function<bool(Vec2)> entryFun, vector<Vec2> directions = Vec2::directions8());
   bool isReachable(Vec2) const;
-  using ReachableSet = HashSet<Vec2>;
-  const ReachableSet& getAllReachable() const;
+  const vector<Vec2>& getAllReachable() const;
 
   private:
-  ReachableSet reachable;
+  Table<bool> visited;
+  vector<Vec2> reachable;
 };
-
@@ -0,0 +1,238 @@
+#include "stdafx.h"
+#include "sim_benchmark.h"
+#include "version.h"
+#include "shortest_path.h"
+#include "time_queue.h"
+#include "creature.h"
+#include "creature_attributes.h"
+#include "view_object.h"
+#include "spell_map.h"
+#include "tribe.h"
+#include "fx_manager.h"
+
+#ifndef WINDOWS
+#include <sys/resource.h>
+#endif
+
+bool PhaseTimers::enabled = false;
+
+static EnumMap<BenchmarkPhase, steady_clock::duration> phaseTotals;
+static EnumMap<BenchmarkPhase, long long> phaseCounts;
+// Phases can be timed on worker threads, for example when off-screen sites are simulated.
+static std::mutex phaseMutex;
+
+void PhaseTimers::setEnabled(bool e) {
+  enabled = e;
+}
+
+void PhaseTimers::reset() {
+  phaseTotals.clear();
+  phaseCounts.clear();
+}
+
+void PhaseTimers::add(BenchmarkPhase phase, steady_clock::duration time) {
+  std::lock_guard<std::mutex> lock(phaseMutex);
+  phaseTotals[phase] += time;
+  ++phaseCounts[phase];
+}
+
+steady_clock::duration PhaseTimers::getTotal(BenchmarkPhase phase) {
+  return phaseTotals[phase];
+}
+
+long long PhaseTimers::getCount(BenchmarkPhase phase) {
+  return phaseCounts[phase];
+}
+
+long long getPeakRssKb() {
+#ifdef WINDOWS
+  return 0;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef OSX
+  // OSX reports bytes instead of kilobytes.
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+BenchmarkResult runPathfindingBenchmark(int numTurns, int seed) {
+  RandomGen random;
+  random.init(seed);
+  Rectangle bounds(200, 200);
+  Table<double> entryCost(bounds, 1);
+  for (int i : Range(600)) {
+    Vec2 pos(random.get(bounds.width()), random.get(bounds.height()));
+    Rectangle wall = Rectangle(pos, pos + Vec2(random.get(1, 12), random.get(1, 3))).intersection(bounds);
+    if (random.roll(2))
+      wall = Rectangle(pos, pos + Vec2(random.get(1, 3), random.get(1, 12))).intersection(bounds);
+    for (Vec2 v : wall)
+      entryCost[v] = ShortestPath::infinity;
+  }
+  auto getRandomFree = [&] {
+    while (true) {
+      Vec2 pos(random.get(bounds.width()), random.get(bounds.height()));
+      if (entryCost[pos] < ShortestPath::infinity)
+        return pos;
+    }
+  };
+  auto entryFun = [&](Vec2 v) { return entryCost[v]; };
+  PhaseTimers::reset();
+  PhaseTimers::setEnabled(true);
+  const auto startTime = steady_clock::now();
+  for (int turn : Range(numTurns)) {
+    BENCHMARK_PHASE(PATHFINDING);
+    for (int i : Range(10)) {
+      Vec2 from = getRandomFree();
+      Vec2 to = getRandomFree();
+      ShortestPath path(entryCost, to, from);
+    }
+    Dijkstra dijkstra(bounds, {getRandomFree()}, 60, entryFun);
+    BfSearch search(bounds, getRandomFree(), [&](Vec2 v) { return entryCost[v] < ShortestPath::infinity; });
+  }
+  const auto totalTime = steady_clock::now() - startTime;
+  PhaseTimers::setEnabled(false);
+  return BenchmarkResult{
+    BenchmarkScenario::PATHFINDING,
+    seed,
+    numTurns,
+    0,
+    totalTime,
+    EnumMap<BenchmarkPhase, steady_clock::duration>([](BenchmarkPhase p) { return PhaseTimers::getTotal(p); }),
+    EnumMap<BenchmarkPhase, long long>([](BenchmarkPhase p) { return PhaseTimers::getCount(p); }),
+    getPeakRssKb()
+  };
+}
+
+BenchmarkResult runTimeQueueBenchmark(int numTurns, int seed) {
+  RandomGen random;
+  random.init(seed);
+  const int numCreatures = 5000;
+  TimeQueue queue;
+  vector<Creature*> creatures;
+  for (int i : Range(numCreatures)) {
+    auto c = makeOwner<Creature>(ViewObject(ViewId("jackal"), ViewLayer::CREATURE), TribeId::getMonster(),
+        CreatureAttributes([](CreatureAttributes&) {}), SpellMap{});
+    creatures.push_back(c.get());
+    queue.addCreature(std::move(c), LocalTime(random.get(10)));
+  }
+  PhaseTimers::reset();
+  PhaseTimers::setEnabled(true);
+  const auto startTime = steady_clock::now();
+  for (int turn : Range(1, numTurns + 1)) {
+    // Roughly the mix of calls that creatures make during a turn.
+    while (auto c = queue.getNextCreature(turn)) {
+      BENCHMARK_PHASE(TIME_QUEUE);
+      int action = random.get(100);
+      if (action < 5)
+        queue.makeExtraMove(c);
+      else if (action < 10 && !queue.hasExtraMove(c))
+        queue.postponeMove(c);
+      else if (action < 12) {
+        queue.moveNow(random.choose(creatures));
+        queue.increaseTime(c, TimeInterval(random.get(1, 4)));
+      } else {
+        queue.willMoveThisTurn(random.choose(creatures));
+        queue.increaseTime(c, TimeInterval(random.get(1, 4)));
+      }
+    }
+  }
+  const auto totalTime = steady_clock::now() - startTime;
+  PhaseTimers::setEnabled(false);
+  return BenchmarkResult{
+    BenchmarkScenario::TIME_QUEUE,
+    seed,
+    numTurns,
+    numCreatures,
+    totalTime,
+    EnumMap<BenchmarkPhase, steady_clock::duration>([](BenchmarkPhase p) { return PhaseTimers::getTotal(p); }),
+    EnumMap<BenchmarkPhase, long long>([](BenchmarkPhase p) { return PhaseTimers::getCount(p); }),
+    getPeakRssKb()
+  };
+}
+
+BenchmarkResult runParticleBenchmark(int numTurns, int seed) {
+  Random.init(seed);
+  fx::FXManager manager;
+  const int maxSystems = 200;
+  std::deque<fx::ParticleSystemId> spawned;
+  long long numUpdates = 0;
+  PhaseTimers::reset();
+  PhaseTimers::setEnabled(true);
+  const auto startTime = steady_clock::now();
+  for (int turn : Range(numTurns)) {
+    for (int i : Range(10)) {
+      auto name = Random.choose<FXName>();
+      auto pos = fx::FVec2(Random.get(-200, 200), Random.get(-200, 200));
+      auto target = fx::FVec2(Random.get(-100, 100), Random.get(-100, 100));
+      spawned.push_back(manager.addSystem(name, fx::InitConfig(pos, target)));
+    }
+    // Looped effects never end on their own.
+    while (spawned.size() > maxSystems) {
+      manager.kill(spawned.front(), false);
+      spawned.pop_front();
+    }
+    for (int step : Range(6)) {
+      {
+        BENCHMARK_PHASE(PARTICLES);
+        manager.simulate(1.0f / 60.0f);
+      }
+      for (auto& system : manager.getSystems())
+        if (!system.isDead)
+          numUpdates += system.numActiveParticles();
+    }
+  }
+  const auto totalTime = steady_clock::now() - startTime;
+  PhaseTimers::setEnabled(false);
+  auto phaseCount = EnumMap<BenchmarkPhase, long long>([](BenchmarkPhase p) { return PhaseTimers::getCount(p); });
+  phaseCount[BenchmarkPhase::PARTICLES] = numUpdates;
+  return BenchmarkResult{
+    BenchmarkScenario::PARTICLES,
+    seed,
+    numTurns,
+    0,
+    totalTime,
+    EnumMap<BenchmarkPhase, steady_clock::duration>([](BenchmarkPhase p) { return PhaseTimers::getTotal(p); }),
+    phaseCount,
+    getPeakRssKb()
+  };
+}
+
+static double toMillis(steady_clock::duration d) {
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void writeBenchmarkJson(ostream& out, const vector<BenchmarkResult>& results) {
+  out << "{\n";
+  out << "  \"version\": \"" << BUILD_VERSION << "\",\n";
+  out << "  \"date\": \"" << BUILD_DATE << "\",\n";
+  out << "  \"results\": [";
+  for (int i : All(results)) {
+    auto& result = results[i];
+    double totalMillis = toMillis(result.totalTime);
+    out << (i > 0 ? ",\n" : "\n");
+    out << "    {\n";
+    out << "      \"scenario\": \"" << toLower(EnumInfo<BenchmarkScenario>::getString(result.scenario)) << "\",\n";
+    out << "      \"seed\": " << result.seed << ",\n";
+    out << "      \"turns\": " << result.numTurns << ",\n";
+    out << "      \"creatures\": " << result.numCreatures << ",\n";
+    out << "      \"total_ms\": " << totalMillis << ",\n";
+    out << "      \"turns_per_second\": " << (totalMillis > 0 ? 1000.0 * result.numTurns / totalMillis : 0.0) << ",\n";
+    out << "      \"peak_rss_kb\": " << result.peakRssKb << ",\n";
+    out << "      \"phases\": {";
+    bool first = true;
+    for (auto phase : ENUM_ALL(BenchmarkPhase)) {
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "        \"" << toLower(EnumInfo<BenchmarkPhase>::getString(phase)) << "\": { \"ms\": "
+          << toMillis(result.phaseTime[phase]) << ", \"calls\": " << result.phaseCount[phase] << " }";
+    }
+    out << "\n      }\n";
+    out << "    }";
+  }
+  out << "\n  ]\n}\n";
+}
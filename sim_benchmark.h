@@ -0,0 +1,88 @@
+#pragma once
+
+#include "util.h"
+
+RICH_ENUM(
+  BenchmarkScenario,
+  SMALL_KEEPER,
+  LATE_GAME,
+  SIEGE,
+  PATHFINDING,
+  TIME_QUEUE,
+  PARTICLES
+);
+
+RICH_ENUM(
+  BenchmarkPhase,
+  MODEL_TICK,
+  LEVEL_TICK,
+  COLLECTIVE_TICK,
+  MONSTER_AI,
+  PATHFINDING,
+  TIME_QUEUE,
+  PARTICLES,
+  SAVE
+);
+
+// Wall time accumulated in the main simulation phases during a headless benchmark run.
+// Phases are inclusive, ie. MODEL_TICK contains LEVEL_TICK and COLLECTIVE_TICK. SAVE is a single save of the game
+// after the last turn, and isn't included in the total time.
+// When the benchmark is not running, the scoped timers cost a single branch.
+class PhaseTimers {
+  public:
+  static void setEnabled(bool);
+  static bool isEnabled() {
+    return enabled;
+  }
+  static void reset();
+  static void add(BenchmarkPhase, steady_clock::duration);
+  static steady_clock::duration getTotal(BenchmarkPhase);
+  static long long getCount(BenchmarkPhase);
+
+  private:
+  static bool enabled;
+};
+
+class ScopedPhaseTimer {
+  public:
+  ScopedPhaseTimer(BenchmarkPhase phase) {
+    if (PhaseTimers::isEnabled()) {
+      this->phase = phase;
+      start = steady_clock::now();
+    }
+  }
+
+  ~ScopedPhaseTimer() {
+    if (phase)
+      PhaseTimers::add(*phase, steady_clock::now() - start);
+  }
+
+  private:
+  optional<BenchmarkPhase> phase;
+  steady_clock::time_point start;
+};
+
+#define BENCHMARK_PHASE(phase) ScopedPhaseTimer PROFILE_CONCAT(phaseTimer, __COUNTER__)(BenchmarkPhase::phase)
+
+struct BenchmarkResult {
+  BenchmarkScenario scenario;
+  int seed;
+  int numTurns;
+  int numCreatures;
+  steady_clock::duration totalTime;
+  EnumMap<BenchmarkPhase, steady_clock::duration> phaseTime;
+  EnumMap<BenchmarkPhase, long long> phaseCount;
+  long long peakRssKb;
+};
+
+// Runs searches on a synthetic 200x200 map instead of simulating a game. Each turn is a batch of
+// ShortestPath, Dijkstra and BfSearch queries between random positions.
+extern BenchmarkResult runPathfindingBenchmark(int numTurns, int seed);
+// Schedules moves of 5000 creatures in a TimeQueue, without running any game logic. TIME_QUEUE phase count
+// is the number of moves.
+extern BenchmarkResult runTimeQueueBenchmark(int numTurns, int seed);
+// Keeps around 200 particle systems alive in an fx::FXManager and simulates them at 60 steps per second, 6 steps
+// per turn. PARTICLES phase count is the number of particle updates.
+extern BenchmarkResult runParticleBenchmark(int numTurns, int seed);
+extern long long getPeakRssKb();
+extern void writeBenchmarkJson(ostream&, const vector<BenchmarkResult>&);
@@ -31,7 +31,7 @@ static int getTableNum(const FilePath& path) {
   return ret;
 }
 
-Table<char> SokobanInput::getNext() {
+vector<Table<char>> SokobanInput::readLevels() const {
   ifstream input(levelsPath.getPath());
   CHECK(input) << "Failed to load sokoban data from " << levelsPath;
   vector<Table<char>> rest;
@@ -42,8 +42,30 @@ Table<char> SokobanInput::getNext() {
       break;
   }
   CHECK(!rest.empty()) << "Failed to load sokoban data from " << levelsPath;
-  input.close();
+  return rest;
+}
+
+// Level generation attempts run on several threads and the state file is shared.
+static std::mutex stateMutex;
+
+Table<char> SokobanInput::getNext() {
+  auto rest = readLevels();
+  if (fixedLevel)
+    return rest[*fixedLevel % rest.size()];
+  std::lock_guard<std::mutex> lock(stateMutex);
   int curLevel = getTableNum(statePath);
   ofstream(statePath.getPath()) << (curLevel + 1);
   return rest[curLevel % rest.size()];
 }
+
+SokobanInput SokobanInput::forSite(int index) const {
+  std::lock_guard<std::mutex> lock(stateMutex);
+  auto ret = *this;
+  ret.fixedLevel = getTableNum(statePath) + index;
+  return ret;
+}
+
+void SokobanInput::skip(int numLevels) {
+  std::lock_guard<std::mutex> lock(stateMutex);
+  ofstream(statePath.getPath()) << (getTableNum(statePath) + numLevels);
+}
@@ -10,7 +10,16 @@ class SokobanInput {
   Table<char> getNext();
   static optional<Table<char> > readTable(ifstream&);
 
+  // Input for one of several campaign sites that are generated at the same time. It always returns the level
+  // numbered by the site's index, counting from the current state, so the level doesn't depend on the order in
+  // which the sites are generated or on how many attempts they take. Call skip() with the number of sites after
+  // they're done to move the state past their levels.
+  SokobanInput forSite(int index) const;
+  void skip(int numLevels);
+
   private:
+  vector<Table<char>> readLevels() const;
   FilePath levelsPath;
   FilePath statePath;
+  optional<int> fixedLevel;
 };
@@ -18,7 +18,11 @@
 
 SERIALIZE_DEF(Statistics, count)
 
+// Off-screen sites can be simulated on worker threads.
+static std::mutex addMutex;
+
 void Statistics::add(StatId id) {
+  std::lock_guard<std::mutex> lock(addMutex);
   ++count[id];
 }
 
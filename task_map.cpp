@@ -6,9 +6,11 @@
 #include "equipment.h"
 #include "collective.h"
 #include "container_range.h"
+#include "level.h"
 
 void TaskMap::addToTaskByActivity(Task* task, MinionActivity activity) {
   taskByActivity[activity].push_back(task);
+  addToGrid(task, activity);
   if (isPriorityTask(task))
     priorityTaskByActivity[activity].insertIfDoesntContain(task);
 }
@@ -25,9 +27,11 @@ void TaskMap::serialize(Archive& ar, const unsigned int) {
   ar(tasks, positionMap, reversePositions, taskByCreature, creatureByTask, marked, completionCost, priorityTasks, delayedTasks, highlight, taskById, taskByActivity, activityByTask);
   if (Archive::is_loading::value) {
     for (auto activity : ENUM_ALL(MinionActivity)) {
-      for (auto& task : taskByActivity[activity])
+      for (auto& task : taskByActivity[activity]) {
         if (isPriorityTask(task))
           priorityTaskByActivity[activity].insertIfDoesntContain(task);
+        addToGrid(task, activity);
+      }
     }
   }
 }
@@ -45,6 +49,7 @@ void TaskMap::tick() {
     for (auto task : Iter(taskByActivity[activity]))
       if (!(*task)->canPerformByAnyone()) {
         task.markToErase();
+        removeFromGrid(*task, activity);
         cantPerformByAnyone[activity].push_back(*task);
       }
     EntitySet<Task> toErase;
@@ -61,24 +66,38 @@ void TaskMap::tick() {
   }
 }
 
+static const int taskGridSize = 8;
+
+static Position getGridKey(Position pos) {
+  return Position(pos.getCoord() / taskGridSize, pos.getLevel());
+}
+
+void TaskMap::addToGrid(Task* task, MinionActivity activity) {
+  if (auto pos = getPosition(task))
+    taskGrid[activity][getGridKey(*pos)].push_back(task);
+}
+
+void TaskMap::removeFromGrid(Task* task, MinionActivity activity) {
+  if (auto pos = getPosition(task)) {
+    auto& grid = taskGrid[activity];
+    auto it = grid.find(getGridKey(*pos));
+    if (it != grid.end()) {
+      it->second.removeElementMaybe(task);
+      if (it->second.empty())
+        grid.erase(it);
+    }
+  }
+}
+
+// Below this number of tasks it's faster to check all of them than to search the grid.
+static const int minTasksForGridSearch = 64;
+
 Task* TaskMap::getClosestTask(const Creature* creature, MinionActivity activity, bool priorityOnly,
     const Collective* col) const {
   auto header = "getClosestTask " + EnumInfo<MinionActivity>::getString(activity);
   PROFILE_BLOCK(header.data());
-  Task* closest = nullptr;
-  auto isBetter = [&](Task* task, optional<int> dist) {
-    PROFILE_BLOCK("isBetter");
-    if (!closest)
-      return true;
-    bool pTask = isPriorityTask(task);
-    bool pClosest = isPriorityTask(closest);
-    if (pTask && !pClosest)
-      return true;
-    if (!pTask && pClosest)
-      return false;
-    return dist.value_or(10000) < getPosition(closest)->dist8(creature->getPosition()).value_or(10000);
-  };
   auto movementType = creature->getMovementType();
+  auto creaturePos = creature->getPosition();
   optional<StorageId> storageDropTask;
   {
     PROFILE_BLOCK("StorageId");
@@ -90,25 +109,87 @@ Task* TaskMap::getClosestTask(const Creature* creature, MinionActivity activity,
             break;
           }
   }
+  // Priority tasks go before all others, otherwise the closest task is chosen. Tasks on other levels are
+  // only chosen if there are none on the creature's level.
+  Task* closest = nullptr;
+  int closestDist = 10000;
+  auto consider = [&](Task* task) {
+    if (auto pos = getPosition(task)) {
+      auto dist = pos->dist8(creaturePos);
+      if (closest && dist.value_or(10000) >= closestDist)
+        return;
+      if ((!storageDropTask || storageDropTask == task->getStorageId(false)) &&
+          task->canPerform(creature, movementType)) {
+        PROFILE_BLOCK("Task check");
+        const Creature* owner = getOwner(task);
+        auto delayed = delayedTasks.getMaybe(task);
+        if (!task->isDone() &&
+            (!owner || (task->canTransfer() && dist && pos->dist8(owner->getPosition()).value_or(10000) > *dist && *dist <= 6)) &&
+            pos->canNavigateToOrNeighbor(creaturePos, movementType) &&
+            (!delayed || *delayed < *creature->getLocalTime())) {
+          closest = task;
+          closestDist = dist.value_or(10000);
+        }
+      }
+    }
+  };
   {
+    PROFILE_BLOCK("Priority");
+    for (auto& task : priorityTaskByActivity[activity].getElems())
+      consider(task);
+  }
+  if (closest || priorityOnly)
+    return closest;
+  auto& taskList = taskByActivity[activity];
+  if (taskList.size() < minTasksForGridSearch) {
     PROFILE_BLOCK("ByActivity");
-    auto& taskList = priorityOnly ? priorityTaskByActivity[activity].getElems() : taskByActivity[activity];
     for (auto& task : taskList)
-      if ((!storageDropTask || storageDropTask == task->getStorageId(false)) &&
-          task->canPerform(creature, movementType))
-        if (auto pos = getPosition(task)) {
-          PROFILE_BLOCK("Task check");
-          auto dist = pos->dist8(creature->getPosition());
-          const Creature* owner = getOwner(task);
-          auto delayed = delayedTasks.getMaybe(task);
-          if (!task->isDone() &&
-              (!owner || (task->canTransfer() && dist && pos->dist8(owner->getPosition()).value_or(10000) > *dist && *dist <= 6)) &&
-              isBetter(task, dist) &&
-              pos->canNavigateToOrNeighbor(creature->getPosition(), movementType) &&
-              (!delayed || *delayed < *creature->getLocalTime())) {
-            closest = task;
-          }
-        }
+      if (!isPriorityTask(task))
+        consider(task);
+    return closest;
+  }
+  {
+    // Visit the squares of the grid in rings around the creature, until they are too far to contain
+    // anything closer than the best task.
+    PROFILE_BLOCK("Grid");
+    auto& grid = taskGrid[activity];
+    auto level = creaturePos.getLevel();
+    auto center = creaturePos.getCoord() / taskGridSize;
+    auto levelBounds = level->getBounds();
+    auto gridBounds = Rectangle(0, 0, (levelBounds.right() + taskGridSize - 1) / taskGridSize,
+        (levelBounds.bottom() + taskGridSize - 1) / taskGridSize);
+    int maxRadius = max(max(center.x - gridBounds.left(), gridBounds.right() - 1 - center.x),
+        max(center.y - gridBounds.top(), gridBounds.bottom() - 1 - center.y));
+    auto visit = [&](Vec2 v) {
+      if (v.inRectangle(gridBounds)) {
+        auto it = grid.find(Position(v, level));
+        if (it != grid.end())
+          for (auto& task : it->second)
+            if (!isPriorityTask(task))
+              consider(task);
+      }
+    };
+    for (int radius = 0; radius <= maxRadius; ++radius) {
+      if (closest && (radius - 1) * taskGridSize + 1 >= closestDist)
+        break;
+      for (int x = -radius; x <= radius; ++x) {
+        visit(center + Vec2(x, -radius));
+        if (radius > 0)
+          visit(center + Vec2(x, radius));
+      }
+      for (int y = -radius + 1; y < radius; ++y) {
+        visit(center + Vec2(-radius, y));
+        visit(center + Vec2(radius, y));
+      }
+    }
+  }
+  if (!closest) {
+    PROFILE_BLOCK("Other levels");
+    for (auto& task : taskList)
+      if (!isPriorityTask(task))
+        if (auto pos = getPosition(task))
+          if (pos->getLevel() != creaturePos.getLevel())
+            consider(task);
   }
   return closest;
 }
@@ -118,6 +199,7 @@ vector<const Task*> TaskMap::getAllTasks() const {
 }
 
 void TaskMap::setPriorityTask(Task* task) {
+  changed = true;
   if (auto activity = activityByTask.getMaybe(task))
     priorityTaskByActivity[*activity].insertIfDoesntContain(task);
   priorityTasks.insert(task);
@@ -129,6 +211,7 @@ Task* TaskMap::addTaskCost(PTask task, Position position, CostInfo cost, MinionA
 }
 
 CostInfo TaskMap::removeTask(Task* task) {
+  changed = true;
   if (!task->isDone())
     task->cancel();
   CostInfo cost;
@@ -146,6 +229,8 @@ CostInfo TaskMap::removeTask(Task* task) {
     creatureByTask.erase(task);
   }
   CHECK(taskByCreature.getSize() == creatureByTask.getSize());
+  if (auto activity = activityByTask.getMaybe(task))
+    removeFromGrid(task, *activity);
   if (auto pos = positionMap.getMaybe(task)) {
     CHECK(reversePositions.count(*pos)) << "Task position not found: " <<
         task->getDescription() << " " << pos->getCoord();
@@ -251,6 +336,7 @@ Task* TaskMap::addTaskFor(PTask task, Creature* c) {
   CHECK(!previousTask) << c->getName().bare() << " already has a task " << previousTask->getDescription();
   CHECK(!taskByCreature.getMaybe(c));
   CHECK(!creatureByTask.getMaybe(task.get()));
+  changed = true;
   taskByCreature.set(c, task.get());
   creatureByTask.set(task.get(), c);
   CHECK(taskByCreature.getSize() == creatureByTask.getSize());
@@ -262,9 +348,11 @@ Task* TaskMap::addTaskFor(PTask task, Creature* c) {
 }
 
 Task* TaskMap::addTask(PTask task, Position position, MinionActivity activity) {
+  changed = true;
   setPosition(task.get(), position);
   taskById.set(task.get(), task.get());
   taskByActivity[activity].push_back(task.get());
+  addToGrid(task.get(), activity);
   CHECK(!activityByTask.getMaybe(task.get()));
   activityByTask.set(task.get(), activity);
   tasks.push_back(std::move(task));
@@ -272,6 +360,7 @@ Task* TaskMap::addTask(PTask task, Position position, MinionActivity activity) {
 }
 
 CostInfo TaskMap::takeTask(Creature* c, Task* task) {
+  changed = true;
   freeTask(task);
   CHECK(taskByCreature.getSize() == creatureByTask.getSize());
   CostInfo cost = freeFromTask(c);
@@ -297,6 +386,7 @@ Creature* TaskMap::getOwner(const Task* task) const {
 
 void TaskMap::freeTask(Task* task) {
   if (auto c = creatureByTask.getMaybe(task)) {
+    changed = true;
     CHECK(taskByCreature.getMaybe(*c));
     taskByCreature.erase(*c);
     creatureByTask.erase(task);
@@ -332,4 +422,10 @@ Task* TaskMap::getTask(UniqueEntity<Task>::Id id) const {
 
 optional<MinionActivity> TaskMap::getTaskActivity(Task* t) const {
   return activityByTask.getMaybe(t);
-}
\ No newline at end of file
+}
+
+bool TaskMap::clearChanged() {
+  bool ret = changed;
+  changed = false;
+  return ret;
+}
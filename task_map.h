@@ -43,6 +43,8 @@ class TaskMap {
   Task* getTask(UniqueEntity<Task>::Id) const;
   void tick();
   optional<MinionActivity> getTaskActivity(Task*) const;
+  // Returns whether tasks were added, removed, assigned or prioritized since the last call.
+  bool clearChanged();
 
   SERIALIZATION_DECL(TaskMap)
 
@@ -62,8 +64,14 @@ class TaskMap {
   EnumMap<MinionActivity, IndexedVector<Task*, UniqueEntity<Task>::Id>> priorityTaskByActivity;
   EnumMap<MinionActivity, vector<Task*>> cantPerformByAnyone;
   EntityMap<Task, MinionActivity> SERIAL(activityByTask);
+  // Tasks from taskByActivity bucketed by squares of the map, so that the closest task can be found without
+  // checking all of them. Keys are positions of the squares in grid coordinates.
+  EnumMap<MinionActivity, HashMap<Position, vector<Task*>>> taskGrid;
+  bool changed = true;
   void releaseOnHoldTask(Task*);
   void setPosition(Task*, Position);
   void addToTaskByActivity(Task*, MinionActivity);
+  void addToGrid(Task*, MinionActivity);
+  void removeFromGrid(Task*, MinionActivity);
 };
 
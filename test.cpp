@@ -48,6 +48,10 @@
 #include "biome_id.h"
 #include "item_types.h"
 #include "creature_attributes.h"
+#include "time_queue.h"
+#include "spell_map.h"
+#include "view_object.h"
+#include "tribe.h"
 
 class Test {
   public:
@@ -80,6 +84,156 @@ class Test {
     CHECK(q.getNextCreature() == ra);*/
   }
 
+  // Move order of the TimeQueue before it was replaced by a calendar queue, for creatures that aren't players.
+  // Empty queues are only dropped in getNext(), like in the original.
+  struct ReferenceTimeQueue {
+    struct Time {
+      int time;
+      bool extraTurn;
+      bool operator < (Time o) const {
+        return time < o.time || (time == o.time && !extraTurn && o.extraTurn);
+      }
+      double getDouble() const {
+        return time + (extraTurn ? 0.5 : 0);
+      }
+    };
+    using Queue = deque<pair<Creature*, int>>;
+    map<Time, Queue> queue;
+    map<Creature*, Time> timeMap;
+
+    void push(Creature* c, bool front) {
+      auto& q = queue[timeMap.at(c)];
+      if (q.empty())
+        q.push_back({c, 1000000000});
+      else if (front)
+        q.push_front({c, q.front().second - 1});
+      else
+        q.push_back({c, q.back().second + 1});
+    }
+    void erase(Creature* c) {
+      auto& q = queue.at(timeMap.at(c));
+      q.erase(std::find_if(q.begin(), q.end(), [c](auto& elem) { return elem.first == c; }));
+    }
+    int getOrder(Creature* c) {
+      for (auto& elem : queue.at(timeMap.at(c)))
+        if (elem.first == c)
+          return elem.second;
+      FATAL << "Creature not queued";
+      return 0;
+    }
+    void add(Creature* c, int time) {
+      timeMap[c] = Time{time, false};
+      push(c, false);
+    }
+    void remove(Creature* c) {
+      erase(c);
+      timeMap.erase(c);
+    }
+    void increaseTime(Creature* c, int diff) {
+      erase(c);
+      timeMap.at(c) = Time{timeMap.at(c).time + diff, false};
+      push(c, false);
+    }
+    void makeExtraMove(Creature* c) {
+      erase(c);
+      auto& time = timeMap.at(c);
+      time = time.extraTurn ? Time{time.time + 1, false} : Time{time.time, true};
+      push(c, false);
+    }
+    void postponeMove(Creature* c) {
+      erase(c);
+      push(c, false);
+    }
+    void moveNow(Creature* c) {
+      erase(c);
+      push(c, true);
+    }
+    bool willMoveThisTurn(Creature* c) {
+      auto time = timeMap.at(c);
+      auto curTime = queue.begin()->first;
+      return time.time == curTime.time && (!time.extraTurn || curTime.extraTurn);
+    }
+    bool compareOrder(Creature* c1, Creature* c2) {
+      if (willMoveThisTurn(c1) != willMoveThisTurn(c2))
+        return willMoveThisTurn(c2);
+      if (!willMoveThisTurn(c1))
+        return c1->getLastMoveCounter() < c2->getLastMoveCounter();
+      auto time1 = timeMap.at(c1);
+      auto time2 = timeMap.at(c2);
+      if (time1 < time2 || time2 < time1)
+        return time1 < time2;
+      return getOrder(c1) < getOrder(c2);
+    }
+    Creature* getNext(double maxTime) {
+      if (timeMap.empty())
+        return nullptr;
+      while (queue.begin()->second.empty())
+        queue.erase(queue.begin());
+      if (queue.begin()->first.getDouble() > maxTime)
+        return nullptr;
+      return queue.begin()->second.front().first;
+    }
+  };
+
+  void testTimeQueueOrder() {
+    RandomGen random;
+    random.init(1234);
+    TimeQueue queue;
+    ReferenceTimeQueue reference;
+    vector<Creature*> creatures;
+    vector<PCreature> removed;
+    for (int i : Range(60)) {
+      auto c = makeOwner<Creature>(ViewObject(ViewId("jackal"), ViewLayer::CREATURE), TribeId::getMonster(),
+          CATTR(c.viewId = ViewId("jackal");), SpellMap{});
+      int time = random.get(10);
+      creatures.push_back(c.get());
+      reference.add(c.get(), time);
+      queue.addCreature(std::move(c), LocalTime(time));
+    }
+    for (int turn : Range(1, 300)) {
+      while (auto c = queue.getNextCreature(turn)) {
+        CHECK(c == reference.getNext(turn)) << "Turn " << turn;
+        auto other = random.choose(creatures);
+        auto other2 = random.choose(creatures);
+        CHECK(queue.willMoveThisTurn(other) == reference.willMoveThisTurn(other));
+        CHECK(queue.compareOrder(other, other2) == reference.compareOrder(other, other2));
+        int action = random.get(100);
+        if (action < 5) {
+          queue.makeExtraMove(c);
+          reference.makeExtraMove(c);
+        } else if (action < 10 && !queue.hasExtraMove(c)) {
+          queue.postponeMove(c);
+          reference.postponeMove(c);
+        } else if (action < 13) {
+          queue.moveNow(other);
+          reference.moveNow(other);
+          int diff = random.get(1, 4);
+          queue.increaseTime(c, TimeInterval(diff));
+          reference.increaseTime(c, diff);
+        } else {
+          int diff = random.get(1, 4);
+          queue.increaseTime(c, TimeInterval(diff));
+          reference.increaseTime(c, diff);
+        }
+      }
+      CHECK(reference.getNext(turn) == nullptr);
+      // Take out a creature and put it back later, at a time that is already queued.
+      if (turn % 7 == 0) {
+        auto c = random.choose(creatures);
+        creatures.removeElement(c);
+        reference.remove(c);
+        removed.push_back(queue.removeCreature(c));
+      } else if (turn % 7 == 3 && !removed.empty()) {
+        auto c = removed.back().get();
+        int time = turn + random.get(3);
+        creatures.push_back(c);
+        reference.add(c, time);
+        queue.addCreature(std::move(removed.back()), LocalTime(time));
+        removed.pop_back();
+      }
+    }
+  }
+
   void testRectangleIterator() {
     vector<Vec2> v1, v2;
     for (Vec2 v : Rectangle(10, 10)) {
@@ -206,6 +360,68 @@ class Test {
     CHECK(res == expected);*/
   }
 
+  void testFlowFieldPath() {
+    vector<string> map {
+        "..........#.",
+        ".########.#.",
+        ".#......#.#.",
+        ".#.####.#...",
+        ".#.#..#.###.",
+        "...#.2#.....",
+        "####.##.###.",
+        "1.......#...",
+    };
+    Table<float> entryCost(Vec2(map[0].size(), map.size()));
+    for (Vec2 v : entryCost.getBounds())
+      entryCost[v] = map[v.y][v.x] == '#' ? ShortestPath::infinity : 1 + (v.x * 7 + v.y * 3) % 4;
+    Vec2 from(0, 7);
+    Vec2 target(5, 5);
+    auto getCost = [&](const vector<Vec2>& path) {
+      double ret = 0;
+      for (int i : Range(1, path.size()))
+        ret += entryCost[path[i]];
+      return ret;
+    };
+    auto fieldPath = FlowField(entryCost, target).getPath(nullptr, from);
+    CHECK(!!fieldPath);
+    CHECK(fieldPath->front() == target && fieldPath->back() == from);
+    auto fieldSteps = fieldPath->reverse();
+    for (int i : Range(1, fieldSteps.size()))
+      CHECK(fieldSteps[i].dist8(fieldSteps[i - 1]) == 1 && entryCost[fieldSteps[i]] < ShortestPath::infinity);
+    ShortestPath path(entryCost.getBounds(),
+        [&](Vec2 pos) { return entryCost[pos]; },
+        [] (Vec2) { return 0; },
+        Vec2::directions8(), target, from);
+    vector<Vec2> res {from};
+    while (res.back() != target)
+      res.push_back(path.getNextMove(res.back()));
+    CHECK(getCost(fieldSteps) == getCost(res)) << getCost(fieldSteps) << " " << getCost(res);
+  }
+
+  void testDijkstraFractionalCosts() {
+    // Costs differ by less than the width of a queue bucket, so the order within a bucket matters.
+    RandomGen random;
+    random.init(123);
+    Rectangle bounds(12, 12);
+    Table<double> entryCost(bounds);
+    for (Vec2 v : bounds)
+      entryCost[v] = 1 + random.getDouble() * 0.2;
+    Table<double> expected(bounds, ShortestPath::infinity);
+    expected[Vec2(0, 0)] = 0;
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (Vec2 v : bounds)
+        for (Vec2 dir : Vec2::directions8())
+          if ((v + dir).inRectangle(bounds) && expected[v] + entryCost[v + dir] < expected[v + dir]) {
+            expected[v + dir] = expected[v] + entryCost[v + dir];
+            changed = true;
+          }
+    }
+    Dijkstra dijkstra(bounds, {Vec2(0, 0)}, 100, [&](Vec2 v) { return entryCost[v]; });
+    for (Vec2 v : bounds)
+      CHECK(fabs(dijkstra.getDist(v) - expected[v]) < 0.00001) << v << " " << dijkstra.getDist(v) << " " << expected[v];
+  }
+
   void testRange() {
     vector<int> a;
     vector<int> b {0,1,2,3,4,5,6};
@@ -540,6 +756,32 @@ class Test {
     CHECK(!s.same(Vec2(0, 0), Vec2(5, 5)));
   }
 
+  void testSectorsCorridor() {
+    Rectangle bounds(64, 20);
+    Sectors s(bounds, Table<optional<Vec2>>(bounds));
+    for (Vec2 v : bounds)
+      if (v.x != 40 || v.y == 18)
+        s.add(v);
+    auto corridor = s.getCorridor(Vec2(2, 2), Vec2(60, 2), 100);
+    CHECK(!!corridor);
+    CHECK(corridor->target == Vec2(60, 2));
+    CHECK(s.isInCorridor(Vec2(2, 2)));
+    CHECK(s.isInCorridor(Vec2(40, 18)));
+    CHECK(!s.isInCorridor(Vec2(40, 2)));
+    corridor = s.getCorridor(Vec2(2, 2), Vec2(60, 2), 2);
+    CHECK(!!corridor);
+    CHECK(corridor->target != Vec2(60, 2));
+    CHECK(s.isInCorridor(corridor->target));
+    CHECK(!s.isInCorridor(Vec2(60, 2)));
+    s.remove(Vec2(40, 18));
+    CHECK(!s.getCorridor(Vec2(2, 2), Vec2(60, 2), 100));
+    s.addExtraConnection(Vec2(35, 5), Vec2(45, 5));
+    corridor = s.getCorridor(Vec2(2, 2), Vec2(60, 2), 100);
+    CHECK(!!corridor);
+    CHECK(s.isInCorridor(Vec2(35, 5)));
+    CHECK(s.isInCorridor(Vec2(45, 5)));
+  }
+
   void testReverse() {
     vector<int> v1 {1, 2, 3, 4};
     vector<int> v2 {4, 3, 2, 1};
@@ -1151,6 +1393,20 @@ class Test {
     CHECK(res == makeVec(1, 2, 3, 4, 5, 6, 7, 8)) << res;
   }
 
+  void testPrettyTokens() {
+    map<string, vector<int>> m;
+    auto err = PrettyPrinting::parseObject(m, "{ \"v1\" { 1 (2*3+1) -5 (10/(2+3)) } }");
+    CHECK(!err) << *err;
+    CHECK(m["v1"] == makeVec(1, 7, -5, 2)) << m["v1"];
+    map<string, string> s;
+    err = PrettyPrinting::parseObject(s, "{ \"a\" \"x\\\" y\" + 5 \"b\" \"\" }");
+    CHECK(!err) << *err;
+    CHECK(s["a"] == "x\" y5") << s["a"];
+    CHECK(s["b"] == "");
+    err = PrettyPrinting::parseObject(s, "{ \"a\" \"x\"\n  \"b\" { } }");
+    CHECK(err == "line: 2 column: 5:\nExpected quoted string, got: {"_s) << *err;
+  }
+
   struct MatchingTest {
     MatchingTest() {
       auto contentFactory = getContentFactory();
@@ -1298,6 +1554,7 @@ class Test {
 void testAll() {
   Test().testStringConvertion();
   Test().testTimeQueue();
+  Test().testTimeQueueOrder();
   Test().testRectangleIterator();
   Test().testValueCheck();
   Test().testSplit();
@@ -1305,6 +1562,8 @@ void testAll() {
   Test().testShortestPath();
   Test().testAStar();
   Test().testShortestPath2();
+  Test().testFlowFieldPath();
+  Test().testDijkstraFractionalCosts();
   Test().testShortestPathReverse();
   Test().testRange();
   Test().testRange2();
@@ -1326,6 +1585,7 @@ void testAll() {
   Test().testSectors2();
   Test().testSectors3();
   Test().testSectorsWithPortals();
+  Test().testSectorsCorridor();
   Test().testReverse();
   Test().testReverse2();
   Test().testReverse3();
@@ -1367,6 +1627,7 @@ void testAll() {
   Test().testPrettyVector();
   Test().testPrettyVector2();
   Test().testPrettyVector3();
+  Test().testPrettyTokens();
   Test().testVectorConcat();
   Test().testVectorConcat2();
   Test().testVectorConcat3();
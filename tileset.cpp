@@ -361,7 +361,7 @@ bool TileSet::loadTilesFromDir(const DirectoryPath& path, Vec2 size, bool overwr
         src.w = size.x;
         src.h = size.y;
         SDL_BlitSurface(im, &src, image, &dest);
-        addedPositions.emplace_back(spriteName, Vec2(posX, posY));
+        addedPositions.emplace_back(spriteName, Vec2(dest.x, dest.y));
         INFO << "Loading tile sprite " << fileName << " at " << posX << "," << posY;
         ++frameCount;
       }
@@ -373,13 +373,44 @@ bool TileSet::loadTilesFromDir(const DirectoryPath& path, Vec2 size, bool overwr
 }
 
 void TileSet::loadTextures() {
-  for (auto& elem : texturesTmp) {
-    textures.push_back(make_unique<Texture>(elem.image));
-    SDL::SDL_FreeSurface(elem.image);
-    for (auto& pos : elem.addedPositions)
-      for (auto& coord : tileCoords[pos.first])
-        coord.texture = textures.back().get();
+  // The sheets are stacked into as few textures as the driver allows, so that the renderer can draw most of the map
+  // without switching textures.
+  SDL::GLint maxSize = 0;
+  SDL::glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  vector<pair<Texture*, int>> sheetPlacement;
+  for (int begin = 0; begin < texturesTmp.size();) {
+    int height = texturesTmp[begin].image->h;
+    int end = begin + 1;
+    while (end < texturesTmp.size() && height + texturesTmp[end].image->h <= maxSize)
+      height += texturesTmp[end++].image->h;
+    SDL::SDL_Surface* atlas = Texture::createSurface(textureWidth, height);
+    SDL::SDL_SetSurfaceBlendMode(atlas, SDL::SDL_BLENDMODE_NONE);
+    vector<int> offsets;
+    int offset = 0;
+    for (int i : Range(begin, end)) {
+      SDL::SDL_Rect dest{0, offset, 0, 0};
+      SDL_BlitSurface(texturesTmp[i].image, nullptr, atlas, &dest);
+      offsets.push_back(offset);
+      offset += texturesTmp[i].image->h;
+      SDL::SDL_FreeSurface(texturesTmp[i].image);
+    }
+    textures.push_back(make_unique<Texture>(atlas));
+    SDL::SDL_FreeSurface(atlas);
+    for (int offset : offsets)
+      sheetPlacement.emplace_back(textures.back().get(), offset);
+    begin = end;
   }
+  // A sprite found again in a later directory either replaces the earlier one or isn't added to the sheet, so the
+  // current coords of each sprite come from the last sheet that contains it.
+  unordered_map<string, int> spriteSheet;
+  for (int i : All(texturesTmp))
+    for (auto& pos : texturesTmp[i].addedPositions)
+      spriteSheet[pos.first] = i;
+  for (auto& elem : spriteSheet)
+    for (auto& coord : tileCoords[elem.first]) {
+      coord.texture = sheetPlacement[elem.second].first;
+      coord.pos.y += sheetPlacement[elem.second].second;
+    }
   for (auto& elem : tileCoords)
     for (auto& coord : elem.second)
       CHECK(!!coord.texture);
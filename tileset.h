@@ -14,6 +14,7 @@ class ScriptedUI;
 
 struct TileCoord {
   Vec2 size;
+  // Pixel position of the top left corner in the texture.
   Vec2 pos;
   Texture* texture = nullptr;
 };
@@ -19,134 +19,210 @@
 #include "creature.h"
 #include "view_object.h"
 
-template <class Archive> 
-void TimeQueue::serialize(Archive& ar, const unsigned int version) { 
+template <class Archive>
+void TimeQueue::serialize(Archive& ar, const unsigned int version) {
+  EntityMap<Creature, ExtendedTime> timeMap;
+  map<ExtendedTime, Queue> queue;
+  if (Archive::is_saving::value)
+    queue = toQueues(timeMap);
   ar(creatures, timeMap, queue);
+  if (Archive::is_loading::value)
+    fromQueues(queue);
 }
 
 SERIALIZABLE(TimeQueue);
 
-void TimeQueue::addCreature(PCreature c, LocalTime time) {
-  timeMap.set(c.get(), time);
-  queue[time].push(c.get());
-  creatures.push_back(std::move(c));
+void TimeQueue::fromQueues(const map<ExtendedTime, Queue>& queue) {
+  for (auto& elem : queue)
+    for (auto* q : {&elem.second.players, &elem.second.nonPlayers})
+      for (auto c : *q)
+        if (c) {
+          // Creatures might not be fully loaded yet, so their list is taken from the save.
+          int index = entries.size();
+          entries.push_back(Entry{c, getKey(elem.first), q == &elem.second.players, 0, -1, -1});
+          entryIndex.set(c, index);
+          reserveKey(entries[index].key);
+          link(index, false);
+        }
 }
 
-LocalTime TimeQueue::getTime(const Creature* c) {
-  return timeMap.getOrFail(c).time;
+map<TimeQueue::ExtendedTime, TimeQueue::Queue> TimeQueue::toQueues(EntityMap<Creature, ExtendedTime>& timeMap) const {
+  map<ExtendedTime, Queue> ret;
+  for (long long key = firstKey; numQueued > 0 && key <= maxKey; ++key) {
+    auto& bucket = buckets[key & (buckets.size() - 1)];
+    for (int player : {0, 1})
+      for (int index = bucket.head[player]; index >= 0; index = entries[index].next) {
+        auto c = entries[index].creature;
+        timeMap.set(c, getTime(key));
+        auto& q = ret[getTime(key)];
+        auto& creatures = player == 0 ? q.players : q.nonPlayers;
+        q.orderMap.set(c, (player == 0 ? 0 : 1000000000) + creatures.size());
+        creatures.push_back(c);
+      }
+  }
+  return ret;
 }
 
-static void clearNull(deque<Creature*>& q) {
-  while (!q.empty() && q.back() == nullptr)
-    q.pop_back();
-  while (!q.empty() && q.front() == nullptr)
-    q.pop_front();
+long long TimeQueue::getKey(ExtendedTime time) {
+  return 2 * (long long) time.time.getInternal() + (time.extraTurn ? 1 : 0);
 }
 
-void TimeQueue::Queue::clearNull() {
-  ::clearNull(players);
-  ::clearNull(nonPlayers);
+TimeQueue::ExtendedTime TimeQueue::getTime(long long key) {
+  ExtendedTime ret(LocalTime(int(key >> 1)));
+  ret.extraTurn = (key & 1);
+  return ret;
 }
 
-void TimeQueue::Queue::push(Creature* c) {
-  clearNull();
-  if (c->isPlayer()) {
-    int order = players.empty() ? 0 : orderMap.getOrFail(players.back()) + 1;
-    orderMap.set(c, order);
-    players.push_back(c);
-  } else {
-    int order = nonPlayers.empty() ? 1000000000 : orderMap.getOrFail(nonPlayers.back()) + 1;
-    orderMap.set(c, order);
-    nonPlayers.push_back(c);
+int TimeQueue::getEntry(const Creature* c) const {
+  return entryIndex.getOrFail(c);
+}
+
+bool TimeQueue::isBefore(const Entry& e1, const Entry& e2) const {
+  if (e1.key != e2.key)
+    return e1.key < e2.key;
+  if (e1.player != e2.player)
+    return e1.player;
+  return e1.order < e2.order;
+}
+
+TimeQueue::Bucket& TimeQueue::getBucket(long long key) {
+  return buckets[key & (buckets.size() - 1)];
+}
+
+void TimeQueue::reserveKey(long long key) {
+  if (buckets.empty())
+    buckets.resize(64);
+  else if (numQueued > 0 || (key >= firstKey && key - firstKey < buckets.size())) {
+    long long low = min(firstKey, key);
+    long long high = max(maxKey, key);
+    if (high - low >= buckets.size()) {
+      int size = buckets.size();
+      while (high - low >= size)
+        size *= 2;
+      vector<Bucket> newBuckets(size);
+      for (long long k = firstKey; k <= maxKey; ++k)
+        newBuckets[k & (size - 1)] = getBucket(k);
+      buckets = std::move(newBuckets);
+    }
+    firstKey = low;
+    maxKey = high;
+    return;
   }
+  // The queue is empty and the key is out of the range of buckets.
+  firstKey = maxKey = key;
 }
 
-void TimeQueue::Queue::pushFront(Creature* c) {
-  clearNull();
-  if (c->isPlayer()) {
-    int order = players.empty() ? 0 : orderMap.getOrFail(players.front()) - 1;
-    orderMap.set(c, order);
-    players.push_front(c);
+void TimeQueue::link(int index, bool toFront) {
+  auto& entry = entries[index];
+  int list = entry.player ? 0 : 1;
+  auto& bucket = getBucket(entry.key);
+  if (toFront) {
+    entry.order = nextFrontOrder--;
+    entry.prev = -1;
+    entry.next = bucket.head[list];
+    if (entry.next >= 0)
+      entries[entry.next].prev = index;
+    else
+      bucket.tail[list] = index;
+    bucket.head[list] = index;
   } else {
-    int order = nonPlayers.empty() ? 1000000000 : orderMap.getOrFail(nonPlayers.front()) - 1;
-    orderMap.set(c, order);
-    nonPlayers.push_front(c);
+    entry.order = nextBackOrder++;
+    entry.next = -1;
+    entry.prev = bucket.tail[list];
+    if (entry.prev >= 0)
+      entries[entry.prev].next = index;
+    else
+      bucket.head[list] = index;
+    bucket.tail[list] = index;
   }
+  ++numQueued;
 }
 
-bool TimeQueue::Queue::empty() {
-  clearNull();
-  return players.empty() && nonPlayers.empty();
+void TimeQueue::unlink(int index) {
+  auto& entry = entries[index];
+  int list = entry.player ? 0 : 1;
+  auto& bucket = getBucket(entry.key);
+  if (entry.prev >= 0)
+    entries[entry.prev].next = entry.next;
+  else
+    bucket.head[list] = entry.next;
+  if (entry.next >= 0)
+    entries[entry.next].prev = entry.prev;
+  else
+    bucket.tail[list] = entry.prev;
+  --numQueued;
 }
 
-Creature* TimeQueue::Queue::front() {
-  clearNull();
-  if (!players.empty())
-    return players.front();
-  else
-    return nonPlayers.front();
+void TimeQueue::requeue(int index, long long key, bool toFront) {
+  if (key < firstKey || key > maxKey || buckets.empty())
+    reserveKey(key);
+  entries[index].key = key;
+  entries[index].player = entries[index].creature->isPlayer();
+  link(index, toFront);
 }
 
-void TimeQueue::Queue::popFront() {
-  if (!players.empty())
-    return players.pop_front();
-  else
-    return nonPlayers.pop_front();
+void TimeQueue::addCreature(PCreature c, LocalTime time) {
+  int index;
+  if (freeEntries.empty()) {
+    index = entries.size();
+    entries.emplace_back();
+  } else {
+    index = freeEntries.back();
+    freeEntries.pop_back();
+  }
+  entries[index].creature = c.get();
+  entryIndex.set(c.get(), index);
+  requeue(index, getKey(time), false);
+  creatures.push_back(std::move(c));
 }
 
-void TimeQueue::Queue::erase(Creature* c) {
-  auto eraseFrom = [&c] (deque<Creature*>& queue) {
-    for (int i : All(queue))
-      if (queue[i] == c) {
-        queue[i] = nullptr;
-        return true;
-      }
-    return false;
-  };
-  CHECK(eraseFrom(players) || eraseFrom(nonPlayers));
+LocalTime TimeQueue::getTime(const Creature* c) {
+  return getTime(entries[getEntry(c)].key).time;
 }
 
 void TimeQueue::increaseTime(Creature* c, TimeInterval diff) {
-  auto& time = timeMap.getOrFail(c);
-  queue.at(time).erase(c);
+  int index = getEntry(c);
+  auto time = getTime(entries[index].key);
+  unlink(index);
   time.time += diff;
   time.extraTurn = false;
-  queue[time].push(c);
+  requeue(index, getKey(time), false);
 }
 
 void TimeQueue::makeExtraMove(Creature* c) {
-  auto& time = timeMap.getOrFail(c);
-  queue.at(time).erase(c);
+  int index = getEntry(c);
+  auto time = getTime(entries[index].key);
+  unlink(index);
   if (!time.extraTurn)
     time.extraTurn = true;
   else {
     time.time += 1_visible;
     time.extraTurn = false;
   }
-  queue[time].push(c);
+  requeue(index, getKey(time), false);
 }
 
 bool TimeQueue::hasExtraMove(Creature* c) {
-  return timeMap.getOrFail(c).extraTurn;
+  return entries[getEntry(c)].key & 1;
 }
 
 void TimeQueue::postponeMove(Creature* c) {
   CHECK(contains(c));
-  auto time = timeMap.getOrFail(c);
-  queue.at(time).erase(c);
-  queue.at(time).push(c);
+  int index = getEntry(c);
+  unlink(index);
+  requeue(index, entries[index].key, false);
 }
 
 void TimeQueue::moveNow(Creature* c) {
   CHECK(contains(c));
-  auto time = timeMap.getOrFail(c);
-  queue.at(time).erase(c);
-  queue.at(time).pushFront(c);
+  int index = getEntry(c);
+  unlink(index);
+  requeue(index, entries[index].key, true);
 }
 
 bool TimeQueue::willMoveThisTurn(const Creature* c) {
-  auto hisTime = timeMap.getOrFail(c);
-  auto curTime = queue.begin()->first;
+  auto hisTime = getTime(entries[getEntry(c)].key);
+  auto curTime = getTime(firstKey);
   return hisTime.time == curTime.time && (!hisTime.extraTurn || curTime.extraTurn);
 }
 
@@ -157,21 +233,11 @@ bool TimeQueue::compareOrder(const Creature* c1, const Creature* c2) {
     return false;
   if (!willMoveThisTurn(c1))
     return c1->getLastMoveCounter() < c2->getLastMoveCounter();
-  auto time1 = timeMap.getOrFail(c1);
-  auto time2 = timeMap.getOrFail(c2);
-  if (time1 < time2)
-    return true;
-  if (time2 < time1)
-    return false;
-  auto& orderMap = queue.at(time1).orderMap;
-  return orderMap.getOrFail(c1) < orderMap.getOrFail(c2);
+  return isBefore(entries[getEntry(c1)], entries[getEntry(c2)]);
 }
 
 bool TimeQueue::contains(Creature* c) const {
-  for (auto& creature : creatures)
-    if (creature.get() == c)
-      return true;
-  return false;
+  return entryIndex.hasKey(c);
 }
 
 TimeQueue::TimeQueue() {}
@@ -179,7 +245,10 @@ TimeQueue::TimeQueue() {}
 PCreature TimeQueue::removeCreature(Creature* cRef) {
   for (int i : All(creatures))
     if (creatures[i].get() == cRef) {
-      queue.at(timeMap.getOrFail(cRef)).erase(cRef);
+      int index = getEntry(cRef);
+      unlink(index);
+      entryIndex.erase(cRef);
+      freeEntries.push_back(index);
       PCreature ret = std::move(creatures[i]);
       creatures.removeIndexPreserveOrder(i);
       return ret;
@@ -192,27 +261,27 @@ vector<Creature*> TimeQueue::getAllCreatures() const {
   return getWeakPointers(creatures);
 }
 
+bool TimeQueue::Bucket::isEmpty() const {
+  return head[0] < 0 && head[1] < 0;
+}
+
 Creature* TimeQueue::getNextCreature(double maxTime) {
   if (creatures.empty())
     return nullptr;
-  while (1) {
-    CHECK(!queue.empty());
-    if (!queue.begin()->second.empty())
-      break;
-    queue.erase(queue.begin());
-  }
-  auto nowTime = queue.begin()->first;
+  CHECK(numQueued > 0);
+  while (getBucket(firstKey).isEmpty())
+    ++firstKey;
+  auto nowTime = getTime(firstKey);
   if (nowTime.getDouble() > maxTime)
     return nullptr;
-  auto& q = queue.begin()->second;
+  // A player with an extra move goes before everyone else moving at the same time.
   if (!nowTime.extraTurn) {
-    auto nextQueue = ++queue.begin();
-    if (nextQueue != queue.end()) {
-      if (nextQueue->first.time == nowTime.time && !nextQueue->second.empty() && nextQueue->second.front()->isPlayer())
-        return nextQueue->second.front();
-    }
+    auto& extraMoves = getBucket(firstKey + 1);
+    if (extraMoves.head[0] >= 0)
+      return entries[extraMoves.head[0]].creature;
   }
-  return q.front();
+  auto& bucket = getBucket(firstKey);
+  return entries[bucket.head[0] >= 0 ? bucket.head[0] : bucket.head[1]].creature;
 }
 
 TimeQueue::ExtendedTime::ExtendedTime() {}
@@ -46,20 +46,12 @@ class TimeQueue {
   bool contains(Creature*) const;
 
   vector<PCreature> SERIAL(creatures);
+  // The save format keeps the queues of creatures for every time. They are only used during serialization.
   struct Queue {
-    void push(Creature*);
-    void pushFront(Creature*);
-    bool empty();
-    Creature* front();
-    void popFront();
-    void erase(Creature*);
     deque<Creature*> SERIAL(players);
     deque<Creature*> SERIAL(nonPlayers);
     EntityMap<Creature, int> SERIAL(orderMap);
     SERIALIZE_ALL(players, nonPlayers, orderMap)
-
-    private:
-    void clearNull();
   };
   struct ExtendedTime {
     ExtendedTime();
@@ -70,7 +62,48 @@ class TimeQueue {
     bool SERIAL(extraTurn) = false;
     SERIALIZE_ALL(time, extraTurn)
   };
-  map<ExtendedTime, Queue> SERIAL(queue);
-  EntityMap<Creature, ExtendedTime> SERIAL(timeMap);
+  // Creatures are kept in a ring of buckets indexed by time, with a separate bucket for extra moves.
+  // Every bucket has two lists of entries, for players and for the rest. The order counter follows the list order,
+  // it's taken from the back for regular moves and from the front for moveNow().
+  struct Entry {
+    Creature* creature;
+    long long key;
+    bool player;
+    long long order;
+    int prev;
+    int next;
+  };
+  struct Bucket {
+    bool isEmpty() const;
+    int head[2] = {-1, -1};
+    int tail[2] = {-1, -1};
+  };
+  static long long getKey(ExtendedTime);
+  static ExtendedTime getTime(long long key);
+  int getEntry(const Creature*) const;
+  bool isBefore(const Entry&, const Entry&) const;
+  Bucket& getBucket(long long key);
+  void link(int entry, bool toFront);
+  void unlink(int entry);
+  // Puts the entry at the end of the bucket of its new time, or at the front with toFront.
+  void requeue(int entry, long long key, bool toFront);
+  // Makes sure that the key fits in the ring together with all queued entries.
+  void reserveKey(long long key);
+  void fromQueues(const map<ExtendedTime, Queue>&);
+  map<ExtendedTime, Queue> toQueues(EntityMap<Creature, ExtendedTime>& timeMap) const;
+
+  // Entries are reused after creatures are removed and the ring only grows when the span of times increases,
+  // so moves don't allocate in steady state.
+  vector<Entry> entries;
+  vector<int> freeEntries;
+  EntityMap<Creature, int> entryIndex;
+  vector<Bucket> buckets;
+  // All queued keys are in [firstKey, firstKey + buckets.size()). Buckets before the first creature are skipped
+  // lazily in getNextCreature(), so firstKey is the current time, as long as the bucket hasn't been skipped.
+  long long firstKey = 0;
+  long long maxKey = 0;
+  int numQueued = 0;
+  long long nextBackOrder = 0;
+  long long nextFrontOrder = -1;
 };
 
@@ -31,18 +31,33 @@ Tribe::Tribe(TribeId d, bool p) : diplomatic(p), friendlyTribes(TribeSet::getFul
 }
 
 double Tribe::getStanding(const Creature* c) const {
-  auto tribeId = c->getTribeId();
+  return getStanding(c->getUniqueId(), c->getTribeId());
+}
+
+double Tribe::getStanding(UniqueEntity<Creature>::Id creature, TribeId tribeId) const {
   if (!friendlyTribes.contains(tribeId))
     return -1;
   if (tribeId == id)
     return 1;
-  if (auto res = standing.getMaybe(c)) 
+  if (auto res = standing.getMaybe(creature))
     return *res;
   return 0;
 }
 
-void Tribe::initStanding(const Creature* c) {
-  standing.set(c, getStanding(c));
+static thread_local vector<function<void()>>* deferredChanges = nullptr;
+
+void Tribe::deferChangesOnThisThread(vector<function<void()>>* changes) {
+  deferredChanges = changes;
+}
+
+void Tribe::lowerStanding(const Creature* c, double amount) {
+  auto apply = [this, creature = c->getUniqueId(), tribeId = c->getTribeId(), amount] {
+    standing.set(creature, getStanding(creature, tribeId) - amount);
+  };
+  if (deferredChanges)
+    deferredChanges->push_back(apply);
+  else
+    apply();
 }
 
 void Tribe::addEnemy(Tribe* t) {
@@ -64,10 +79,8 @@ void Tribe::onMemberKilled(Creature* member, Creature* attacker) {
   CHECK(member->getTribe() == this);
   if (attacker == nullptr)
     return;
-  if (diplomatic) {
-    initStanding(attacker);
-    standing.getOrFail(attacker) -= killPenalty * getMultiplier(member);
-  }
+  if (diplomatic)
+    lowerStanding(attacker, killPenalty * getMultiplier(member));
 }
 
 bool Tribe::isEnemy(const Creature* c) const {
@@ -84,9 +97,12 @@ const TribeSet& Tribe::getFriendlyTribes() const {
 
 void Tribe::onItemsStolen(Creature* attacker) {
   if (diplomatic) {
-    initStanding(attacker);
-    standing.getOrFail(attacker) -= thiefPenalty;
-    addEnemy(attacker->getTribe());
+    lowerStanding(attacker, thiefPenalty);
+    auto attackerTribe = attacker->getTribe();
+    if (deferredChanges)
+      deferredChanges->push_back([this, attackerTribe] { addEnemy(attackerTribe); });
+    else
+      addEnemy(attackerTribe);
   }
 }
 
@@ -97,6 +97,10 @@ class Tribe {
   void onMemberKilled(Creature* member, Creature* killer);
   void onItemsStolen(Creature* thief);
 
+  // Tribes are shared by all sites, including the ones updated on worker threads. While a list is set on a thread,
+  // the changes that these calls make are added to it instead of applied, to be run later on the main thread.
+  static void deferChangesOnThisThread(vector<function<void()>>*);
+
   SERIALIZATION_DECL(Tribe)
 
   typedef HashMap<TribeId, PTribe> Map;
@@ -107,10 +111,11 @@ class Tribe {
   Tribe(TribeId, bool diplomatic);
   static void init(Tribe::Map&, TribeId, bool diplomatic);
   double getStanding(const Creature*) const;
+  double getStanding(UniqueEntity<Creature>::Id, TribeId) const;
 
   bool SERIAL(diplomatic);
 
-  void initStanding(const Creature*);
+  void lowerStanding(const Creature*, double amount);
   double getMultiplier(const Creature* member);
 
   EntityMap<Creature, double> SERIAL(standing);
@@ -24,7 +24,7 @@ RandomGen::RandomGen() {
 
 void RandomGen::init(int seed) {
   PROFILE;
-  generator.seed(seed);
+  getGenerator().seed(seed);
 }
 
 int RandomGen::get(int max) {
@@ -32,7 +32,7 @@ int RandomGen::get(int max) {
 }
 
 long long RandomGen::getLL() {
-  return uniform_int_distribution<long long>(-(1LL << 62), 1LL << 62)(generator);
+  return uniform_int_distribution<long long>(-(1LL << 62), 1LL << 62)(getGenerator());
 }
 
 int RandomGen::get(Range r) {
@@ -41,7 +41,7 @@ int RandomGen::get(Range r) {
 
 int RandomGen::get(int min, int max) {
   CHECK(max > min);
-  return uniform_int_distribution<int>(min, max - 1)(generator);
+  return uniform_int_distribution<int>(min, max - 1)(getGenerator());
 }
 
 std::string operator "" _s(const char* str, size_t) { 
@@ -89,11 +89,11 @@ bool RandomGen::chance(float v) {
 }
 
 double RandomGen::getDouble() {
-  return defaultDist(generator);
+  return defaultDist(getGenerator());
 }
 
 double RandomGen::getDouble(double a, double b) {
-  return uniform_real_distribution<double>(a, b)(generator);
+  return uniform_real_distribution<double>(a, b)(getGenerator());
 }
 
 pair<float, float> RandomGen::getFloat2Fast() {
@@ -105,7 +105,7 @@ pair<float, float> RandomGen::getFloat2Fast() {
 }
 
 float RandomGen::getFloat(float a, float b) {
-  return uniform_real_distribution<float>(a, b)(generator);
+  return uniform_real_distribution<float>(a, b)(getGenerator());
 }
 
 float RandomGen::getFloatFast(float a, float b) {
@@ -115,6 +115,16 @@ float RandomGen::getFloatFast(float a, float b) {
 
 RandomGen Random;
 
+thread_local RandomGen* RandomGen::threadOverride = nullptr;
+
+ScopedRandomOverride::ScopedRandomOverride(RandomGen& random) : previous(RandomGen::threadOverride) {
+  RandomGen::threadOverride = &random;
+}
+
+ScopedRandomOverride::~ScopedRandomOverride() {
+  RandomGen::threadOverride = previous;
+}
+
 template string toString<int>(const int&);
 template string toString<unsigned int>(const unsigned int&);
 //template string toString<size_t>(const size_t&);
@@ -1022,6 +1032,64 @@ scoped_thread makeScopedThread(function<void()> fun) {
   return scoped_thread(makeThread(std::move(fun)));
 }
 
+ThreadPool::ThreadPool(int numThreads) {
+  CHECK(numThreads > 0);
+  for (int i : Range(numThreads))
+    threads.push_back(makeThread([this] { workerLoop(); }));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(mut);
+    done = true;
+  }
+  taskAdded.notify_all();
+  for (auto& t : threads)
+    t.join();
+}
+
+void ThreadPool::addTask(function<void()> task) {
+  {
+    std::unique_lock<std::mutex> lock(mut);
+    tasks.push(std::move(task));
+    ++numUnfinished;
+  }
+  taskAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mut);
+  tasksFinished.wait(lock, [this] { return numUnfinished == 0; });
+}
+
+int ThreadPool::getNumThreads() const {
+  return threads.size();
+}
+
+int ThreadPool::getDefaultNumThreads() {
+  return max<int>(1, thread::hardware_concurrency());
+}
+
+void ThreadPool::workerLoop() {
+  while (true) {
+    function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mut);
+      taskAdded.wait(lock, [this] { return done || !tasks.empty(); });
+      if (tasks.empty())
+        return;
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+    {
+      std::unique_lock<std::mutex> lock(mut);
+      if (--numUnfinished == 0)
+        tasksFinished.notify_all();
+    }
+  }
+}
+
 //#endif
 
 ConstructorFunction::ConstructorFunction(function<void()> fun) {
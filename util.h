@@ -808,7 +808,7 @@ class RandomGen {
 
   template <typename T>
   vector<T> permutation(vector<T> v) {
-    std::shuffle(v.begin(), v.end(), generator);
+    std::shuffle(v.begin(), v.end(), getGenerator());
     return v;
   }
 
@@ -824,7 +824,7 @@ class RandomGen {
 
   template <typename Iterator>
   void shuffle(Iterator begin, Iterator end) {
-    std::shuffle(begin, end, generator);
+    std::shuffle(begin, end, getGenerator());
   }
 
   template <typename T>
@@ -844,7 +844,7 @@ class RandomGen {
   template <typename T>
   vector<T> permutation(initializer_list<T> vi) {
     vector<T> v(vi);
-    std::shuffle(v.begin(), v.end(), generator);
+    std::shuffle(v.begin(), v.end(), getGenerator());
     return v;
   }
 
@@ -852,14 +852,14 @@ class RandomGen {
     vector<int> v;
     for (int i : r)
       v.push_back(i);
-    std::shuffle(v.begin(), v.end(), generator);
+    std::shuffle(v.begin(), v.end(), getGenerator());
     return v;
   }
 
   template <typename T>
   vector<T> chooseN(int n, vector<T> v) {
     CHECK(n <= v.size());
-    std::shuffle(v.begin(), v.end(), generator);
+    std::shuffle(v.begin(), v.end(), getGenerator());
     return v.getPrefix(n);
   }
 
@@ -874,6 +874,9 @@ class RandomGen {
   }
 
   private:
+  friend class ScopedRandomOverride;
+  std::mt19937& getGenerator();
+  static thread_local RandomGen* threadOverride;
   std::mt19937 generator;
   std::uniform_real_distribution<double> defaultDist;
 
@@ -890,6 +893,24 @@ class RandomGen {
 
 extern RandomGen Random;
 
+inline std::mt19937& RandomGen::getGenerator() {
+  if (threadOverride && this == &Random)
+    return threadOverride->generator;
+  return generator;
+}
+
+// While alive, calls to the global Random made on the current thread use the given generator. Lets worker threads
+// run game code without racing on the global state, and with results that don't depend on scheduling.
+class ScopedRandomOverride {
+  public:
+  ScopedRandomOverride(RandomGen&);
+  ~ScopedRandomOverride();
+  ScopedRandomOverride(const ScopedRandomOverride&) = delete;
+
+  private:
+  RandomGen* previous;
+};
+
 inline std::ostream& operator <<(std::ostream& d, Rectangle rect) {
   return d << "(" << rect.left() << "," << rect.top() << ") (" << rect.right() << "," << rect.bottom() << ")";
 }
@@ -1788,6 +1809,27 @@ class scoped_thread {
 
 scoped_thread makeScopedThread(function<void()> fun);
 
+// Fixed set of worker threads. Tasks can be added from any thread, wait() blocks until all of them have finished.
+class ThreadPool {
+  public:
+  ThreadPool(int numThreads);
+  ~ThreadPool();
+  void addTask(function<void()>);
+  void wait();
+  int getNumThreads() const;
+  static int getDefaultNumThreads();
+
+  private:
+  void workerLoop();
+  std::mutex mut;
+  std::condition_variable taskAdded;
+  std::condition_variable tasksFinished;
+  queue<function<void()>> tasks;
+  int numUnfinished = 0;
+  bool done = false;
+  vector<thread> threads;
+};
+
 void openUrl(const string& url);
 
 template <typename T, typename... Args>
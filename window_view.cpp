@@ -311,31 +311,33 @@ void WindowView::rebuildGui() {
     mapGui->onMouseGone();
     guiBuilder.mouseGone = true;
   };
-  tempGuiElems.push_back(gui.stack(makeVec(
-      gui.keyHandler(bindMethod(&WindowView::keyboardAction, this)),
-      gui.keyHandler([this]{ zoom(0); }, Keybinding("ZOOM_MAP"), true),
-      gui.keyHandler([this]{ zoom(0); }, {gui.getKey(C_ZOOM)}, true),
-      gui.keyHandler([this]{ guiBuilder.toggleEnlargedMinimap(); }, {gui.getKey(C_MINI_MAP)}, true),
-      gui.keyHandlerBool([this] {
-        if (guiBuilder.isEnlargedMinimap()) {
-          guiBuilder.toggleEnlargedMinimap();
-          return true;
-        }
-        return false;
-      }, Keybinding("EXIT_MENU")),
-      gui.keyHandler([getMovement]{ getMovement(0, -1); }, Keybinding("WALK_NORTH"), false),
-      gui.keyHandler([getMovement]{ getMovement(0, 1); }, Keybinding("WALK_SOUTH"), false),
-      gui.keyHandler([getMovement]{ getMovement(1, 0); }, Keybinding("WALK_EAST"), false),
-      gui.keyHandler([getMovement]{ getMovement(-1, 0); }, Keybinding("WALK_WEST"), false),
-      gui.keyHandler([getMovement]{ getMovement(1, -1); }, Keybinding("WALK_NORTH_EAST"), false),
-      gui.keyHandler([getMovement]{ getMovement(-1, -1); }, Keybinding("WALK_NORTH_WEST"), false),
-      gui.keyHandler([getMovement]{ getMovement(1, 1); }, Keybinding("WALK_SOUTH_EAST"), false),
-      gui.keyHandler([getMovement]{ getMovement(-1, 1); }, Keybinding("WALK_SOUTH_WEST"), false),
-      gui.keyHandler([getMovement]{ getMovement(0, -1); }, Keybinding("WALK_NORTH2"), false),
-      gui.keyHandler([getMovement]{ getMovement(0, 1); }, Keybinding("WALK_SOUTH2"), false),
-      gui.keyHandler([getMovement]{ getMovement(1, 0); }, Keybinding("WALK_EAST2"), false),
-      gui.keyHandler([getMovement]{ getMovement(-1, 0); }, Keybinding("WALK_WEST2"), false)
-  )));
+  if (!mapKeyHandlers)
+    mapKeyHandlers = gui.stack(makeVec(
+        gui.keyHandler(bindMethod(&WindowView::keyboardAction, this)),
+        gui.keyHandler([this]{ zoom(0); }, Keybinding("ZOOM_MAP"), true),
+        gui.keyHandler([this]{ zoom(0); }, {gui.getKey(C_ZOOM)}, true),
+        gui.keyHandler([this]{ guiBuilder.toggleEnlargedMinimap(); }, {gui.getKey(C_MINI_MAP)}, true),
+        gui.keyHandlerBool([this] {
+          if (guiBuilder.isEnlargedMinimap()) {
+            guiBuilder.toggleEnlargedMinimap();
+            return true;
+          }
+          return false;
+        }, Keybinding("EXIT_MENU")),
+        gui.keyHandler([getMovement]{ getMovement(0, -1); }, Keybinding("WALK_NORTH"), false),
+        gui.keyHandler([getMovement]{ getMovement(0, 1); }, Keybinding("WALK_SOUTH"), false),
+        gui.keyHandler([getMovement]{ getMovement(1, 0); }, Keybinding("WALK_EAST"), false),
+        gui.keyHandler([getMovement]{ getMovement(-1, 0); }, Keybinding("WALK_WEST"), false),
+        gui.keyHandler([getMovement]{ getMovement(1, -1); }, Keybinding("WALK_NORTH_EAST"), false),
+        gui.keyHandler([getMovement]{ getMovement(-1, -1); }, Keybinding("WALK_NORTH_WEST"), false),
+        gui.keyHandler([getMovement]{ getMovement(1, 1); }, Keybinding("WALK_SOUTH_EAST"), false),
+        gui.keyHandler([getMovement]{ getMovement(-1, 1); }, Keybinding("WALK_SOUTH_WEST"), false),
+        gui.keyHandler([getMovement]{ getMovement(0, -1); }, Keybinding("WALK_NORTH2"), false),
+        gui.keyHandler([getMovement]{ getMovement(0, 1); }, Keybinding("WALK_SOUTH2"), false),
+        gui.keyHandler([getMovement]{ getMovement(1, 0); }, Keybinding("WALK_EAST2"), false),
+        gui.keyHandler([getMovement]{ getMovement(-1, 0); }, Keybinding("WALK_WEST2"), false)
+    ));
+  tempGuiElems.push_back(mapKeyHandlers);
   tempGuiElems.back()->setBounds(getMapGuiBounds());
   if (gameInfo.takingScreenshot) {
     right = gui.empty();
@@ -514,7 +516,10 @@ void WindowView::updateView(CreatureView* view, bool noRefresh) {
   if (!noRefresh)
     uiLock = false;
   switchTiles();
+  auto rebuildStart = steady_clock::now();
+  int numElems = getNumCreatedGuiElems();
   rebuildGui();
+  guiBuilder.setGuiRebuildStats(steady_clock::now() - rebuildStart, getNumCreatedGuiElems() - numElems);
   mapGui->setSpriteMode(currentTileLayout.sprites);
   bool spectator = gameInfo.infoType == GameInfo::InfoType::SPECTATOR;
   mapGui->updateObjects(view, renderer, mapLayout, true, !spectator, gameInfo.tutorial);
@@ -137,6 +137,8 @@ class WindowView: public View {
   SGuiElem mapDecoration;
   SGuiElem minimapDecoration;
   vector<SGuiElem> tempGuiElems;
+  // Map controls don't depend on the game state, so they are built only once.
+  SGuiElem mapKeyHandlers;
   vector<SGuiElem> blockingElems;
   vector<SGuiElem> getAllGuiElems();
   vector<SGuiElem> getClickableGuiElems();